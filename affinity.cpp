@@ -0,0 +1,118 @@
+#include "affinity.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <stdexcept>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int parseCore(const std::string& text)
+{
+    try {
+        size_t used;
+        int core = std::stoi(text, &used);
+        if (used == text.size() && core >= 0 && core < CPU_SETSIZE) return core;
+    } catch (const std::exception&) {
+    }
+    throw std::invalid_argument("Invalid core number '" + text + "'");
+}
+
+CpuSet parseCpuSet(const std::string& text)
+{
+    CpuSet cpus;
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        size_t dash = item.find('-');
+        int first = parseCore(item.substr(0, dash));
+        int last = dash == std::string::npos ? first : parseCore(item.substr(dash + 1));
+        if (first > last) {
+            throw std::invalid_argument("Invalid core range '" + item + "'");
+        }
+        for (int core = first; core <= last; ++core) {
+            cpus.push_back(core);
+        }
+    }
+    if (cpus.empty()) {
+        throw std::invalid_argument("Empty core list");
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+std::vector<CpuSet> parseCpuSets(const std::string& text)
+{
+    std::vector<CpuSet> sets;
+    std::stringstream in(text);
+    std::string group;
+    while (std::getline(in, group, ':')) {
+        sets.push_back(parseCpuSet(group));
+    }
+    return sets;
+}
+
+CpuSet availableCpus()
+{
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CpuSet cpus;
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+        for (int core = 0; core < CPU_SETSIZE; ++core) {
+            if (CPU_ISSET(core, &mask)) cpus.push_back(core);
+        }
+    }
+    return cpus;
+}
+
+void checkCpuSet(const CpuSet& cpus)
+{
+    CpuSet available = availableCpus();
+    for (int core : cpus) {
+        if (!std::binary_search(available.begin(), available.end(), core)) {
+            throw std::invalid_argument("Core " + std::to_string(core) + " is not available (available: " +
+                                        describeCpuSet(available) + ")");
+        }
+    }
+}
+
+void pinCurrentThread(const CpuSet& cpus)
+{
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (int core : cpus) {
+        CPU_SET(core, &mask);
+    }
+    int error = pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask);
+    if (error != 0) {
+        throw std::runtime_error("Pinning to cores " + describeCpuSet(cpus) + " failed: " + strerror(error));
+    }
+}
+
+bool preferLocalMemory()
+{
+    // glibc has no wrapper for set_mempolicy; call it directly instead of depending on libnuma
+    return syscall(SYS_set_mempolicy, MPOL_LOCAL, nullptr, 0) == 0;
+}
+
+void placeCurrentThread(const CpuSet& cpus)
+{
+    if (cpus.empty()) return;
+    pinCurrentThread(cpus);
+    preferLocalMemory();
+}
+
+std::string describeCpuSet(const CpuSet& cpus)
+{
+    std::string text;
+    for (int core : cpus) {
+        if (!text.empty()) text += ',';
+        text += std::to_string(core);
+    }
+    return text;
+}
@@ -0,0 +1,41 @@
+#ifndef AFFINITY_HPP
+#define AFFINITY_HPP
+
+#include <string>
+#include <vector>
+
+// A set of core numbers a thread may run on
+using CpuSet = std::vector<int>;
+
+// Parses a core list such as "0-3,6" (throws invalid_argument)
+CpuSet parseCpuSet(const std::string& text);
+
+// Parses core lists separated by ':' such as "0-1:2:3", one set per stage
+std::vector<CpuSet> parseCpuSets(const std::string& text);
+
+// Cores this process may run on (its affinity mask at startup)
+CpuSet availableCpus();
+
+// Throws invalid_argument if a core of cpus is not available to the process
+void checkCpuSet(const CpuSet& cpus);
+
+// Restricts the calling thread to cpus; throws runtime_error on failure
+void pinCurrentThread(const CpuSet& cpus);
+
+// Makes the calling thread's future allocations come from the NUMA node it runs on (MPOL_LOCAL),
+// overriding an inherited policy such as numactl --interleave. Returns false if the kernel has
+// no NUMA support.
+bool preferLocalMemory();
+
+/**
+ * Function: placeCurrentThread
+ * Pins the calling thread to cpus and makes its allocations node-local, so buffers the thread
+ * touches first (graphs it builds, matrices it copies) live next to the cores that process
+ * them. Does nothing for an empty set. Meant to be called first thing in a worker thread.
+ */
+void placeCurrentThread(const CpuSet& cpus);
+
+// "0,1,2" for messages
+std::string describeCpuSet(const CpuSet& cpus);
+
+#endif // AFFINITY_HPP
@@ -1,16 +1,21 @@
 #include "boruvka.hpp"
+#include "trace.hpp"
 
 #include <iostream>
 #include <tuple>
 #include <unordered_set>
 #include <vector>
 #include <functional>
+#include <algorithm>
 
 using namespace std;
 
+constexpr int CANCEL_CHECK_MASK = 65535; // Poll the cancel token every 65536 edges
+
 vector<tuple<int, int, int, int>>
-	boruvka(const vector<tuple<int, int, int, int>>& edges, int n)
+	boruvka(const vector<tuple<int, int, int, int>>& edges, int n, const CancelToken& token)
 {
+	TRACE_SPAN("boruvka");
 	vector<int> component(n, -1);
 	vector<int> cheapest(n, -1);
 	vector<tuple<int, int, int, int>> ans;
@@ -20,6 +25,8 @@ vector<tuple<int, int, int, int>>
 	int graph_cc = n;
 	while (graph_cc > 1)
 	{
+		TRACE_SPAN("boruvka.round");
+		token.check();
 		// tenho que descobrir as componentes do grafo já selecionado
 		fill(cheapest.begin(), cheapest.end(), -1);
 		fill(component.begin(), component.end(), -1);
@@ -41,6 +48,7 @@ vector<tuple<int, int, int, int>>
 
 		for (int i = 0; i < m; ++i)
 		{
+			if ((i & CANCEL_CHECK_MASK) == 0) token.check();
 			int from, to, cost;
 			tie(from, to, cost, ignore) = edges[i];
 			to = component[to];
@@ -54,6 +62,11 @@ vector<tuple<int, int, int, int>>
 		
 		unordered_set<int> inserted_edges_id;
 
+		// No component has an outgoing edge: the remaining components can never merge
+		// (disconnected graph), the selected edges already form a spanning forest
+		if (all_of(cheapest.begin(), cheapest.begin() + cur_cc, [](int e) { return e == -1; }))
+			break;
+
 		for (int i = 0; i < n; ++i)
 		{
 			if (cheapest[i] == -1) continue;
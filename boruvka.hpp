@@ -3,11 +3,15 @@
 
 #include <utility>
 #include <vector>
+#include "cancel.hpp"
 
 using namespace std;
 
 // Implementation of Boruvka's algorithm for finding a MST
+// For a disconnected graph the result is a minimum spanning forest (one tree per component).
 // Complexity: O(m log n)
-vector<tuple<int, int, int, int>> boruvka(const vector<tuple<int, int, int, int>>& edges, int n);
+// The token is polled every round and while scanning the edges; a cancelled run throws Cancelled.
+vector<tuple<int, int, int, int>> boruvka(const vector<tuple<int, int, int, int>>& edges, int n,
+	const CancelToken& token = CancelToken());
 
 #endif
\ No newline at end of file
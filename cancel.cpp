@@ -0,0 +1,40 @@
+#include "cancel.hpp"
+
+CancelToken CancelToken::withTimeout(std::chrono::milliseconds timeout)
+{
+    CancelToken token;
+    token.state = std::make_shared<State>();
+    if (timeout.count() > 0) {
+        token.state->hasDeadline = true;
+        token.state->deadline = Clock::now() + timeout;
+    }
+    return token;
+}
+
+void CancelToken::cancel(const std::string& reason) const
+{
+    if (!state) return;
+    std::lock_guard<std::mutex> lock(state->reasonMutex);
+    if (state->flag.load(std::memory_order_relaxed)) return;
+    state->reason = reason;
+    state->flag.store(true, std::memory_order_release);
+}
+
+bool CancelToken::cancelled() const
+{
+    if (!state) return false;
+    if (state->flag.load(std::memory_order_acquire)) return true;
+    return state->hasDeadline && Clock::now() >= state->deadline;
+}
+
+void CancelToken::check() const
+{
+    if (!state) return;
+    if (state->flag.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(state->reasonMutex);
+        throw Cancelled(state->reason);
+    }
+    if (state->hasDeadline && Clock::now() >= state->deadline) {
+        throw Cancelled("Request deadline exceeded");
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef CANCEL_HPP
+#define CANCEL_HPP
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+// Thrown by CancelToken::check() once the request was cancelled or ran past its deadline
+class Cancelled : public std::runtime_error {
+public:
+    explicit Cancelled(const std::string& reason) : std::runtime_error(reason) {}
+};
+
+/**
+ * Class: CancelToken
+ * Cooperative cancellation of one request. Copies share the same state, so the session can
+ * cancel (e.g. on peer hangup) while worker threads poll the token from inside long loops.
+ * A default constructed token is never cancelled and costs a null check to poll.
+ */
+class CancelToken {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    CancelToken() = default;
+
+    // Token that expires after timeout (no deadline if timeout is zero)
+    static CancelToken withTimeout(std::chrono::milliseconds timeout);
+
+    // Thread-safe; the first reason wins
+    void cancel(const std::string& reason = "Request cancelled") const;
+
+    // Whether the request should stop (cancelled or past the deadline)
+    bool cancelled() const;
+
+    // Throws Cancelled if the request should stop
+    void check() const;
+
+private:
+    struct State {
+        std::atomic<bool> flag{false};
+        bool hasDeadline = false;
+        Clock::time_point deadline;
+        std::mutex reasonMutex;
+        std::string reason;       // Set once, before flag
+    };
+    std::shared_ptr<State> state;
+};
+
+#endif // CANCEL_HPP
@@ -0,0 +1,115 @@
+#include "distance_sampler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <random>
+
+#define Z_95 1.959963984540054 // Two-sided 95% quantile of the normal distribution
+
+// Constructor: adjacency lists from the matrix and a random source order
+DistanceSampler::DistanceSampler(const Graph& graph, uint64_t seed, ThreadPool& pool)
+    : adj(graph.getVertexCount()), order(graph.getVertexCount()), pool(pool)
+{
+    int n = graph.getVertexCount();
+    for (int u = 0; u < n; ++u) {
+        const std::vector<int>& row = graph.row(u);
+        for (int v = 0; v < n; ++v) {
+            if (u != v && row[v] > 0) adj[u].emplace_back(v, row[v]);
+        }
+    }
+    for (int v = 0; v < n; ++v) order[v] = v;
+    std::mt19937_64 random(seed);
+    std::shuffle(order.begin(), order.end(), random);
+}
+
+DistanceSampler::SourceResult DistanceSampler::dijkstra(int source) const
+{
+    const long long INF = std::numeric_limits<long long>::max();
+    std::vector<long long> dist(adj.size(), INF);
+    using Entry = std::pair<long long, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    dist[source] = 0;
+    queue.emplace(0, source);
+
+    SourceResult result{0.0, 0, 0, false};
+    while (!queue.empty()) {
+        auto [d, u] = queue.top();
+        queue.pop();
+        if (d > dist[u]) continue;
+        if (u != source) {
+            result.distanceSum += static_cast<double>(d);
+            ++result.pairs;
+            result.eccentricity = std::max(result.eccentricity, d);
+        }
+        for (const auto& [v, w] : adj[u]) {
+            if (d + w < dist[v]) {
+                dist[v] = d + w;
+                queue.emplace(dist[v], v);
+            }
+        }
+    }
+    result.reachesAll = result.pairs + 1 == static_cast<long long>(adj.size());
+    return result;
+}
+
+DistanceEstimate DistanceSampler::step(int batch, const CancelToken& token)
+{
+    if (batch <= 0) batch = static_cast<int>(std::max<size_t>(1, pool.size()));
+    int count = std::min(batch, static_cast<int>(order.size()) - next);
+    std::vector<SourceResult> found(count);
+    pool.parallelFor(0, count, [&](size_t i) {
+        token.check();
+        found[i] = dijkstra(order[next + i]);
+    });
+    results.insert(results.end(), found.begin(), found.end());
+    next += count;
+    return estimate();
+}
+
+DistanceEstimate DistanceSampler::estimate() const
+{
+    DistanceEstimate estimate{0.0, 0.0, 0, -1, next, static_cast<int>(order.size()), finished()};
+    double sum = 0;
+    long long pairs = 0;
+    bool connected = false;
+    long long smallestEccentricity = std::numeric_limits<long long>::max();
+    for (const SourceResult& result : results) {
+        sum += result.distanceSum;
+        pairs += result.pairs;
+        estimate.longestAtLeast = std::max(estimate.longestAtLeast, result.eccentricity);
+        if (result.reachesAll) {
+            connected = true;
+            smallestEccentricity = std::min(smallestEccentricity, result.eccentricity);
+        }
+    }
+    // In a connected graph every shortest path is at most twice the eccentricity of any vertex
+    if (connected) estimate.longestAtMost = 2 * smallestEccentricity;
+    if (estimate.exact) estimate.longestAtMost = estimate.longestAtLeast;
+    if (pairs == 0) {
+        // Only isolated sources so far: nothing is known about the average yet
+        if (!estimate.exact) estimate.halfWidth = std::numeric_limits<double>::infinity();
+        return estimate;
+    }
+
+    // Ratio estimator: average = sum(y) / sum(c), with y the distance sum and c the pair count of a source
+    double k = static_cast<double>(results.size());
+    double n = static_cast<double>(order.size());
+    double ratio = sum / static_cast<double>(pairs);
+    estimate.average = ratio;
+    if (estimate.exact || results.size() < 2) {
+        estimate.halfWidth = estimate.exact ? 0.0 : std::numeric_limits<double>::infinity();
+        return estimate;
+    }
+    double residuals = 0;
+    for (const SourceResult& result : results) {
+        double residual = result.distanceSum - ratio * static_cast<double>(result.pairs);
+        residuals += residual * residual;
+    }
+    double meanPairs = static_cast<double>(pairs) / k;
+    double variance = (1.0 - k / n) * (residuals / (k - 1)) / (k * meanPairs * meanPairs);
+    estimate.halfWidth = Z_95 * std::sqrt(std::max(0.0, variance));
+    return estimate;
+}
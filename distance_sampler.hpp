@@ -0,0 +1,70 @@
+#ifndef DISTANCE_SAMPLER_HPP
+#define DISTANCE_SAMPLER_HPP
+
+#include "cancel.hpp"
+#include "graph.hpp"
+#include "parallel.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// Estimate of the shortest-path distances of a graph after some sampled sources
+struct DistanceEstimate {
+    double average;            // Average distance over the connected pairs
+    double halfWidth;          // Half width of the 95% confidence interval of average (0 once exact,
+                               // infinite while no sampled source reached another vertex)
+    long long longestAtLeast;  // Longest shortest path seen so far, a lower bound of the diameter
+    long long longestAtMost;   // Upper bound of the diameter (2 x smallest eccentricity), -1 if unknown
+    int sources;               // Sources sampled so far
+    int vertices;
+    bool exact;                // Every vertex was a source: the values are exact
+
+    // Half width relative to the average: 0 once exact, infinite while no pair was reached
+    double relativeError() const
+    {
+        if (halfWidth == 0) return 0.0;
+        return average > 0 ? halfWidth / average : std::numeric_limits<double>::infinity();
+    }
+};
+
+/**
+ * Class: DistanceSampler
+ * Estimates the average and longest shortest-path distance of a graph without the O(n^3) of
+ * Floyd-Warshall. Sources are drawn without replacement in a seeded random order; each step runs
+ * Dijkstra from the next batch of sources in parallel and tightens the estimate. The average is
+ * the ratio (sum of distances) / (connected pairs) over the sampled sources, with a 95% confidence
+ * interval from the delta method and the finite population correction, so it closes to the exact
+ * value once every vertex was sampled.
+ */
+class DistanceSampler {
+public:
+    DistanceSampler(const Graph& graph, uint64_t seed = 1,
+                    ThreadPool& pool = ThreadPool::shared());
+
+    // Samples up to batch more sources (0 for one per pool thread) and returns the updated estimate
+    DistanceEstimate step(int batch = 0, const CancelToken& token = CancelToken());
+
+    DistanceEstimate estimate() const;
+    bool finished() const { return next == static_cast<int>(order.size()); }
+
+private:
+    // What Dijkstra from one source found
+    struct SourceResult {
+        double distanceSum;     // Sum of the distances to the reachable vertices
+        long long pairs;        // Number of reachable vertices (excluding the source)
+        long long eccentricity; // Largest distance to a reachable vertex
+        bool reachesAll;
+    };
+
+    std::vector<std::vector<std::pair<int, int>>> adj; // (neighbour, weight)
+    std::vector<int> order;                            // Sources in sampling order
+    std::vector<SourceResult> results;                 // Results of the sampled sources
+    int next = 0;
+    ThreadPool& pool;
+
+    SourceResult dijkstra(int source) const;
+};
+
+#endif // DISTANCE_SAMPLER_HPP
@@ -0,0 +1,361 @@
+#include "external_mst.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <unistd.h>
+#include <vector>
+
+#define IO_BUFFER (1 << 20)          // Bytes per input/output stream buffer
+#define PROGRESS_EDGES (1ULL << 22)  // Edges between two progress reports
+
+// On-disk edge record, also the in-memory format of runs
+struct DiskEdge {
+    int32_t u, v, w;
+
+    bool operator<(const DiskEdge& other) const
+    {
+        if (w != other.w) return w < other.w;
+        if (u != other.u) return u < other.u;
+        return v < other.v;
+    }
+};
+
+static std::runtime_error ioError(const std::string& what, const std::string& path)
+{
+    return std::runtime_error(what + " " + path + " failed: " + strerror(errno));
+}
+
+// Closes a FILE* when it goes out of scope
+struct FileCloser {
+    void operator()(FILE* file) const { fclose(file); }
+};
+using File = std::unique_ptr<FILE, FileCloser>;
+
+static File openFile(const std::string& path, const char* mode)
+{
+    File file(fopen(path.c_str(), mode));
+    if (!file) throw ioError("Opening", path);
+    return file;
+}
+
+// Shared byte counters of one externalMst call
+struct IoCounters {
+    uint64_t read = 0;
+    uint64_t written = 0;
+};
+
+/**
+ * Class: EdgeInput
+ * Streams the edges of the input file: "u v w" triples separated by any whitespace, or packed
+ * int32 records in binary mode.
+ */
+class EdgeInput {
+public:
+    EdgeInput(const std::string& path, bool binary, IoCounters& io)
+        : path(path), file(openFile(path, "rb")), binary(binary), io(io), buffer(IO_BUFFER) {}
+
+    bool next(DiskEdge& edge)
+    {
+        if (binary) {
+            if (!fill(sizeof(DiskEdge))) return false;
+            memcpy(&edge, buffer.data() + pos, sizeof(DiskEdge));
+            pos += sizeof(DiskEdge);
+            if (edge.u < 0 || edge.v < 0) {
+                throw std::invalid_argument(path + ": edge out of range (" + std::to_string(edge.u) + " " +
+                                            std::to_string(edge.v) + " " + std::to_string(edge.w) + ")");
+            }
+            return true;
+        }
+        long long u, v, w;
+        if (!readNumber(u)) return false;
+        if (!readNumber(v) || !readNumber(w)) {
+            throw std::invalid_argument(path + ": incomplete edge at the end of the file");
+        }
+        if (u < 0 || v < 0 || u > INT32_MAX || v > INT32_MAX || w < INT32_MIN || w > INT32_MAX) {
+            throw std::invalid_argument(path + ": edge out of range (" + std::to_string(u) + " " +
+                                        std::to_string(v) + " " + std::to_string(w) + ")");
+        }
+        edge = {static_cast<int32_t>(u), static_cast<int32_t>(v), static_cast<int32_t>(w)};
+        return true;
+    }
+
+private:
+    std::string path;
+    File file;
+    bool binary;
+    IoCounters& io;
+    std::vector<char> buffer;
+    size_t pos = 0, len = 0;
+
+    // Makes at least want bytes available unless the file ends first
+    bool fill(size_t want)
+    {
+        if (len - pos >= want) return true;
+        memmove(buffer.data(), buffer.data() + pos, len - pos);
+        len -= pos;
+        pos = 0;
+        size_t got = fread(buffer.data() + len, 1, buffer.size() - len, file.get());
+        if (got == 0 && ferror(file.get())) throw ioError("Reading", path);
+        len += got;
+        io.read += got;
+        if (len - pos >= want) return true;
+        if (len != pos && binary) {
+            throw std::invalid_argument(path + ": truncated binary edge record");
+        }
+        return false;
+    }
+
+    bool readNumber(long long& value)
+    {
+        // Skip whitespace
+        while (true) {
+            if (pos == len && !fill(1)) return false;
+            if (!isspace(static_cast<unsigned char>(buffer[pos]))) break;
+            ++pos;
+        }
+        bool negative = false;
+        if (buffer[pos] == '-') {
+            negative = true;
+            ++pos;
+        }
+        int digits = 0;
+        value = 0;
+        while ((pos < len || fill(1)) && isdigit(static_cast<unsigned char>(buffer[pos]))) {
+            if (++digits > 18) throw std::invalid_argument(path + ": number too long");
+            value = value * 10 + (buffer[pos++] - '0');
+        }
+        if (digits == 0 || (pos < len && !isspace(static_cast<unsigned char>(buffer[pos])))) {
+            throw std::invalid_argument(path + ": invalid number in edge list");
+        }
+        if (negative) value = -value;
+        return true;
+    }
+};
+
+/**
+ * Class: Run
+ * A sorted run in a temporary file, removed when the run is destroyed.
+ */
+class Run {
+public:
+    Run(const std::string& dir, const DiskEdge* edges, size_t count, IoCounters& io)
+    {
+        std::string pattern = dir + "/mst_runXXXXXX";
+        std::vector<char> name(pattern.begin(), pattern.end());
+        name.push_back('\0');
+        int fd = mkstemp(name.data());
+        if (fd < 0) throw ioError("Creating a run in", dir);
+        path = name.data();
+        close(fd);
+        if (count > 0) append(edges, count, io);
+    }
+    ~Run() { unlink(path.c_str()); }
+    Run(const Run&) = delete;
+    Run& operator=(const Run&) = delete;
+
+    const std::string& name() const { return path; }
+
+    void append(const DiskEdge* edges, size_t count, IoCounters& io)
+    {
+        File file = openFile(path, "ab");
+        if (fwrite(edges, sizeof(DiskEdge), count, file.get()) != count) throw ioError("Writing", path);
+        io.written += count * sizeof(DiskEdge);
+    }
+
+private:
+    std::string path;
+};
+
+/**
+ * Class: RunReader
+ * Buffered sequential reader of a run, holding one record ahead for the merge.
+ */
+class RunReader {
+public:
+    RunReader(const Run& run, size_t bufferEdges, IoCounters& io)
+        : path(run.name()), file(openFile(path, "rb")), io(io), buffer(std::max<size_t>(1, bufferEdges)) {}
+
+    bool next(DiskEdge& edge)
+    {
+        if (pos == len) {
+            len = fread(buffer.data(), sizeof(DiskEdge), buffer.size(), file.get());
+            if (len == 0 && ferror(file.get())) throw ioError("Reading", path);
+            io.read += len * sizeof(DiskEdge);
+            pos = 0;
+            if (len == 0) return false;
+        }
+        edge = buffer[pos++];
+        return true;
+    }
+
+private:
+    std::string path;
+    File file;
+    IoCounters& io;
+    std::vector<DiskEdge> buffer;
+    size_t pos = 0, len = 0;
+};
+
+// K-way merge of runs, calling sink(edge) in weight order until it returns false
+template <typename Sink>
+static void mergeRuns(const std::vector<std::unique_ptr<Run>>& runs, size_t bufferEdges, IoCounters& io, Sink sink)
+{
+    std::vector<std::unique_ptr<RunReader>> readers;
+    using Head = std::pair<DiskEdge, size_t>;
+    auto later = [](const Head& a, const Head& b) { return b.first < a.first; };
+    std::priority_queue<Head, std::vector<Head>, decltype(later)> heads(later);
+
+    for (const auto& run : runs) {
+        readers.push_back(std::make_unique<RunReader>(*run, bufferEdges, io));
+        DiskEdge edge;
+        if (readers.back()->next(edge)) heads.emplace(edge, readers.size() - 1);
+    }
+    while (!heads.empty()) {
+        auto [edge, source] = heads.top();
+        heads.pop();
+        if (!sink(edge)) return;
+        DiskEdge following;
+        if (readers[source]->next(following)) heads.emplace(following, source);
+    }
+}
+
+ExternalMstStats externalMst(const std::string& edgeFile, const std::string& treeFile, const ExternalMstOptions& options)
+{
+    ExternalMstStats stats;
+    IoCounters io;
+    auto report = [&](const char* phase, uint64_t edges) {
+        if (options.progress) options.progress({phase, edges, io.read, io.written});
+    };
+
+    // Pass 1: sorted runs filling the budget left next to the input buffer. The run buffer is
+    // reserved once: growing it by doubling would briefly hold one and a half times the budget.
+    size_t runBytes = options.memoryBudget > 2 * IO_BUFFER ? options.memoryBudget - IO_BUFFER : options.memoryBudget;
+    size_t runEdges = std::max<size_t>(1, runBytes / sizeof(DiskEdge));
+    std::vector<DiskEdge> buffer;
+    buffer.reserve(runEdges);
+    std::vector<std::unique_ptr<Run>> runs;
+    int64_t maxVertex = -1;
+    {
+        EdgeInput input(edgeFile, options.binaryInput, io);
+        DiskEdge edge;
+        while (input.next(edge)) {
+            maxVertex = std::max<int64_t>(maxVertex, std::max(edge.u, edge.v));
+            buffer.push_back(edge);
+            if (++stats.edges % PROGRESS_EDGES == 0) report("runs", stats.edges);
+            if (buffer.size() == runEdges) {
+                std::sort(buffer.begin(), buffer.end());
+                runs.push_back(std::make_unique<Run>(options.tempDir, buffer.data(), buffer.size(), io));
+                buffer.clear();
+            }
+        }
+    }
+    std::sort(buffer.begin(), buffer.end());
+    if (!runs.empty()) {
+        // The edges are all on disk: the merge and Kruskal phases get the whole budget
+        if (!buffer.empty()) {
+            runs.push_back(std::make_unique<Run>(options.tempDir, buffer.data(), buffer.size(), io));
+        }
+        buffer.clear();
+        buffer.shrink_to_fit();
+    }
+    stats.runs = runs.size();
+    report("runs", stats.edges);
+
+    stats.vertices = options.vertices > 0 ? options.vertices : static_cast<int>(maxVertex + 1);
+    if (maxVertex >= stats.vertices) {
+        throw std::invalid_argument("Vertex " + std::to_string(maxVertex) + " out of range for " +
+                                    std::to_string(stats.vertices) + " vertices");
+    }
+
+    // Merge passes until one merge can take all runs; every stream gets an equal share of the budget
+    size_t fanIn = std::max<size_t>(2, options.memoryBudget / IO_BUFFER - 1);
+    auto streamEdges = [&options](size_t streams) {
+        return std::max<size_t>(1, options.memoryBudget / (streams + 1) / sizeof(DiskEdge));
+    };
+    while (runs.size() > fanIn) {
+        ++stats.mergePasses;
+        std::vector<std::unique_ptr<Run>> merged;
+        uint64_t mergedEdges = 0;
+        for (size_t first = 0; first < runs.size(); first += fanIn) {
+            size_t last = std::min(runs.size(), first + fanIn);
+            std::vector<std::unique_ptr<Run>> group;
+            for (size_t i = first; i < last; ++i) group.push_back(std::move(runs[i]));
+
+            size_t outEdges = streamEdges(group.size());
+            auto out = std::make_unique<Run>(options.tempDir, nullptr, 0, io);
+            std::vector<DiskEdge> pending;
+            pending.reserve(outEdges);
+            mergeRuns(group, outEdges, io, [&](const DiskEdge& edge) {
+                pending.push_back(edge);
+                if (pending.size() == outEdges) {
+                    out->append(pending.data(), pending.size(), io);
+                    pending.clear();
+                }
+                if (++mergedEdges % PROGRESS_EDGES == 0) report("merge", mergedEdges);
+                return true;
+            });
+            out->append(pending.data(), pending.size(), io);
+            merged.push_back(std::move(out));
+        }
+        runs = std::move(merged);
+        report("merge", mergedEdges);
+    }
+
+    // Kruskal over the edges in weight order; union by size with path halving
+    File tree;
+    if (!treeFile.empty()) {
+        tree = openFile(treeFile, "w");
+        setvbuf(tree.get(), nullptr, _IOFBF, IO_BUFFER);
+    }
+    std::vector<int32_t> parent(stats.vertices), size(stats.vertices, 1);
+    for (int v = 0; v < stats.vertices; ++v) parent[v] = v;
+    auto find = [&parent](int32_t v) {
+        while (parent[v] != v) {
+            parent[v] = parent[parent[v]];
+            v = parent[v];
+        }
+        return v;
+    };
+
+    uint64_t scanned = 0;
+    uint64_t spanning = stats.vertices > 0 ? stats.vertices - 1 : 0;
+    auto kruskal = [&](const DiskEdge& edge) {
+        if (++scanned % PROGRESS_EDGES == 0) report("kruskal", scanned);
+        int32_t a = find(edge.u), b = find(edge.v);
+        if (a == b) return true;
+        if (size[a] < size[b]) std::swap(a, b);
+        parent[b] = a;
+        size[a] += size[b];
+        ++stats.treeEdges;
+        stats.totalWeight += edge.w;
+        if (tree) {
+            int written = fprintf(tree.get(), "%d %d %d\n", edge.u, edge.v, edge.w);
+            if (written < 0) throw ioError("Writing", treeFile);
+            io.written += written;
+        }
+        // A spanning tree is complete: the remaining edges cannot join anything
+        return stats.treeEdges < spanning;
+    };
+
+    if (runs.empty()) {
+        // The whole input fit in one buffer: no run was written
+        for (const DiskEdge& edge : buffer) {
+            if (!kruskal(edge)) break;
+        }
+    } else {
+        mergeRuns(runs, streamEdges(runs.size()), io, kruskal);
+    }
+    if (tree && fflush(tree.get()) != 0) throw ioError("Writing", treeFile);
+    report("kruskal", scanned);
+
+    stats.components = static_cast<int>(stats.vertices - stats.treeEdges);
+    stats.bytesRead = io.read;
+    stats.bytesWritten = io.written;
+    return stats;
+}
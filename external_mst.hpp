@@ -0,0 +1,53 @@
+#ifndef EXTERNAL_MST_HPP
+#define EXTERNAL_MST_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Where an external MST run is, reported through ExternalMstOptions::progress
+struct ExternalMstProgress {
+    const char* phase;       // "runs", "merge" or "kruskal"
+    uint64_t edges;          // Edges handled so far in this phase
+    uint64_t bytesRead;      // Total bytes read from disk so far (input, runs)
+    uint64_t bytesWritten;   // Total bytes written to disk so far (runs, tree)
+};
+
+struct ExternalMstOptions {
+    size_t memoryBudget = 256u << 20;  // Bytes for all edge buffers: input, runs and merge streams
+    std::string tempDir = "/tmp";      // Where sorted runs are written
+    bool binaryInput = false;          // Input is int32 (u, v, w) records instead of "u v w" lines
+    int vertices = 0;                  // Number of vertices, 0 to take the largest vertex + 1
+    std::function<void(const ExternalMstProgress&)> progress;  // Called every few million edges
+};
+
+struct ExternalMstStats {
+    uint64_t edges = 0;          // Edges in the input
+    int vertices = 0;
+    uint64_t runs = 0;           // Sorted runs written by the first pass
+    int mergePasses = 0;         // Intermediate merge passes (0 if the runs fit one merge)
+    uint64_t treeEdges = 0;
+    long long totalWeight = 0;
+    int components = 0;          // Trees in the spanning forest
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+};
+
+/**
+ * Function: externalMst
+ * Semi-external minimum spanning forest of an edge file that may not fit in memory. Only the
+ * union-find over the vertices (8 bytes per vertex) and memoryBudget bytes of edge buffers are
+ * kept in memory:
+ * 1. The input is read in chunks filling memoryBudget (less the 1 MiB input buffer, for budgets
+ *    above 2 MiB), each sorted by weight and written as a run. The chunk buffer is allocated once
+ *    and freed before the merge whenever runs were written.
+ * 2. Runs are merged k at a time while there are more than fit in one merge.
+ * 3. The last merge streams the edges in weight order into Kruskal, which writes the tree edges
+ *    ("u v w" lines) to treeFile and stops as soon as the forest is complete.
+ * Throws runtime_error on I/O errors and invalid_argument on malformed input.
+ */
+ExternalMstStats externalMst(const std::string& edgeFile, const std::string& treeFile,
+                             const ExternalMstOptions& options = ExternalMstOptions());
+
+#endif // EXTERNAL_MST_HPP
@@ -0,0 +1,156 @@
+#include "forest.hpp"
+#include "prim.hpp"
+#include "boruvka.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#define EDGE_GRAIN 4096   // Edges per parallelFor chunk when labelling components
+#define VERTEX_GRAIN 4096 // Vertices per parallelFor chunk when compressing labels
+
+// Root of v's set, halving the path on the way (safe to run concurrently with unite)
+static int findRoot(std::vector<std::atomic<int>>& parent, int v)
+{
+    while (true) {
+        int p = parent[v].load(std::memory_order_acquire);
+        if (p == v) return v;
+        int grandparent = parent[p].load(std::memory_order_acquire);
+        if (grandparent != p) {
+            parent[v].compare_exchange_weak(p, grandparent, std::memory_order_acq_rel);
+        }
+        v = grandparent;
+    }
+}
+
+// Links the roots of a and b. The larger root is hung under the smaller one, and only while it
+// is still a root (CAS), so every set ends up rooted at its smallest vertex.
+static void unite(std::vector<std::atomic<int>>& parent, int a, int b)
+{
+    while (true) {
+        a = findRoot(parent, a);
+        b = findRoot(parent, b);
+        if (a == b) return;
+        if (a < b) std::swap(a, b);
+        int expected = a;
+        if (parent[a].compare_exchange_strong(expected, b, std::memory_order_acq_rel)) return;
+    }
+}
+
+std::vector<int> labelComponents(const std::vector<std::tuple<int, int, int, int>>& edges, int n, ThreadPool& pool,
+                                 const CancelToken& token)
+{
+    std::vector<std::atomic<int>> parent(n);
+    for (int v = 0; v < n; ++v) {
+        parent[v].store(v, std::memory_order_relaxed);
+    }
+
+    pool.parallelFor(0, edges.size(), [&](size_t i) {
+        if (i % EDGE_GRAIN == 0) token.check();
+        unite(parent, std::get<0>(edges[i]), std::get<1>(edges[i]));
+    }, EDGE_GRAIN);
+
+    std::vector<int> root(n);
+    pool.parallelFor(0, n, [&](size_t v) {
+        root[v] = findRoot(parent, static_cast<int>(v));
+    }, VERTEX_GRAIN);
+
+    // Roots are the smallest vertex of their component, so one increasing pass numbers the
+    // components by root and every member comes after its root
+    std::vector<int> componentOf(n);
+    int components = 0;
+    for (int v = 0; v < n; ++v) {
+        componentOf[v] = (root[v] == v) ? components++ : componentOf[root[v]];
+    }
+    return componentOf;
+}
+
+// Weighted diameter of a tree given as local edges over vertices [0, size): farthest vertex from
+// any vertex, then the farthest distance from that one
+static long long treeDiameter(const std::vector<std::tuple<int, int, int, int>>& tree, int size)
+{
+    if (size <= 1) return 0;
+    std::vector<std::vector<std::pair<int, int>>> adj(size);
+    for (const auto& [u, v, w, id] : tree) {
+        adj[u].emplace_back(v, w);
+        adj[v].emplace_back(u, w);
+    }
+
+    auto farthest = [&adj, size](int source) {
+        std::vector<long long> dist(size, -1);
+        std::vector<int> stack = {source};
+        dist[source] = 0;
+        int best = source;
+        while (!stack.empty()) {
+            int u = stack.back();
+            stack.pop_back();
+            if (dist[u] > dist[best]) best = u;
+            for (const auto& [v, w] : adj[u]) {
+                if (dist[v] < 0) {
+                    dist[v] = dist[u] + w;
+                    stack.push_back(v);
+                }
+            }
+        }
+        return std::make_pair(best, dist[best]);
+    };
+
+    return farthest(farthest(0).first).second;
+}
+
+SpanningForest spanningForest(const std::vector<std::tuple<int, int, int, int>>& edges, int n,
+                              const std::string& algo, ThreadPool& pool, const CancelToken& token)
+{
+    SpanningForest forest;
+    forest.componentOf = labelComponents(edges, n, pool, token);
+    int count = n == 0 ? 0 : *std::max_element(forest.componentOf.begin(), forest.componentOf.end()) + 1;
+
+    // Local numbering of the vertices inside their component
+    std::vector<std::vector<int>> members(count);
+    std::vector<int> localIndex(n);
+    for (int v = 0; v < n; ++v) {
+        std::vector<int>& group = members[forest.componentOf[v]];
+        localIndex[v] = static_cast<int>(group.size());
+        group.push_back(v);
+    }
+
+    std::vector<std::vector<std::tuple<int, int, int, int>>> componentEdges(count);
+    for (const auto& [u, v, w, id] : edges) {
+        componentEdges[forest.componentOf[u]].emplace_back(localIndex[u], localIndex[v], w, id);
+    }
+
+    // One MST per component, concurrently
+    std::vector<std::vector<std::tuple<int, int, int, int>>> trees(count);
+    forest.components.resize(count);
+    pool.parallelFor(0, count, [&](size_t c) {
+        token.check();
+        int size = static_cast<int>(members[c].size());
+        std::vector<std::tuple<int, int, int, int>> local =
+            algo == "boruvka" ? boruvka(componentEdges[c], size, token) : prim(componentEdges[c], size, token);
+
+        ComponentStats& stats = forest.components[c];
+        stats.root = members[c][0];
+        stats.vertices = size;
+        stats.edges = static_cast<int>(local.size());
+        stats.totalWeight = 0;
+        stats.maxEdgeWeight = 0;
+        for (const auto& edge : local) {
+            stats.totalWeight += std::get<2>(edge);
+            stats.maxEdgeWeight = std::max(stats.maxEdgeWeight, std::get<2>(edge));
+        }
+        stats.diameter = treeDiameter(local, size);
+
+        // Back to global vertex numbers
+        for (auto& [u, v, w, id] : local) {
+            u = members[c][u];
+            v = members[c][v];
+        }
+        trees[c] = std::move(local);
+    });
+
+    for (auto& tree : trees) {
+        forest.edges.insert(forest.edges.end(), tree.begin(), tree.end());
+    }
+    return forest;
+}
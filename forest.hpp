@@ -0,0 +1,40 @@
+#ifndef FOREST_HPP
+#define FOREST_HPP
+
+#include "cancel.hpp"
+#include "parallel.hpp"
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Analytics of one connected component and its spanning tree
+struct ComponentStats {
+    int root;               // Smallest vertex of the component, used as its name
+    int vertices;
+    int edges;              // Tree edges, vertices - 1
+    long long totalWeight;  // Weight of the component's spanning tree
+    long long diameter;     // Longest weighted path inside the spanning tree
+    int maxEdgeWeight;      // Heaviest tree edge (0 for a single vertex)
+};
+
+struct SpanningForest {
+    std::vector<std::tuple<int, int, int, int>> edges;  // Tree edges of all components, by component
+    std::vector<int> componentOf;                       // Component index of every vertex
+    std::vector<ComponentStats> components;             // Ordered by root vertex
+};
+
+// Labels the connected components with a concurrent union-find over the edge list.
+// Components are numbered in the order of their smallest vertex.
+std::vector<int> labelComponents(const std::vector<std::tuple<int, int, int, int>>& edges, int n,
+                                 ThreadPool& pool = ThreadPool::shared(),
+                                 const CancelToken& token = CancelToken());
+
+// Minimum spanning forest of a possibly disconnected graph: components are labelled in parallel,
+// then the MST of every component is computed concurrently with prim or boruvka.
+// Once the token is cancelled the remaining chunks and components stop and Cancelled is thrown.
+SpanningForest spanningForest(const std::vector<std::tuple<int, int, int, int>>& edges, int n,
+                              const std::string& algo, ThreadPool& pool = ThreadPool::shared(),
+                              const CancelToken& token = CancelToken());
+
+#endif // FOREST_HPP
@@ -0,0 +1,280 @@
+#include "generator.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+
+#define ROW_GRAIN 16          // Vertices per parallelFor chunk for the pairwise generators
+#define CANDIDATE_BATCH 65536 // Candidate edges drawn per round by the G(n,m) generator
+#define INSERT_BATCH 65536    // Edges added to the graph between two token checks
+
+// Independent random streams derived from the seed
+enum Stream : uint64_t { WEIGHT = 1, EDGE = 2, POINT = 3, CANDIDATE = 4 };
+
+// SplitMix64 finalizer: a good 64-bit mixing function
+static uint64_t mix(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Counter-based random number: the same (seed, stream, a, b) always gives the same value,
+// whichever thread asks and in whatever order
+static uint64_t randomOf(uint64_t seed, uint64_t stream, uint64_t a, uint64_t b)
+{
+    return mix(mix(mix(seed ^ (stream << 56)) ^ a) ^ b);
+}
+
+// Uniform double in [0, 1)
+static double unitOf(uint64_t bits)
+{
+    return static_cast<double>(bits >> 11) * 0x1.0p-53;
+}
+
+static int weightOf(const GeneratorSpec& spec, int u, int v)
+{
+    uint64_t range = static_cast<uint64_t>(spec.maxWeight - spec.minWeight) + 1;
+    return spec.minWeight + static_cast<int>(randomOf(spec.seed, WEIGHT, u, v) % range);
+}
+
+static double parseDouble(const std::string& key, const std::string& value)
+{
+    try {
+        size_t used;
+        double result = std::stod(value, &used);
+        if (used == value.size()) return result;
+    } catch (const std::exception&) {
+    }
+    throw std::invalid_argument("Invalid value for " + key + ": " + value);
+}
+
+static long long parseInteger(const std::string& key, const std::string& value)
+{
+    try {
+        size_t used;
+        long long result = std::stoll(value, &used);
+        if (used == value.size()) return result;
+    } catch (const std::exception&) {
+    }
+    throw std::invalid_argument("Invalid value for " + key + ": " + value);
+}
+
+static int parseInt(const std::string& key, const std::string& value)
+{
+    long long result = parseInteger(key, value);
+    if (result < INT_MIN || result > INT_MAX) {
+        throw std::invalid_argument("Value out of range for " + key + ": " + value);
+    }
+    return static_cast<int>(result);
+}
+
+GeneratorSpec parseGeneratorSpec(const std::string& text)
+{
+    std::istringstream in(text);
+    std::string kind;
+    if (!(in >> kind)) {
+        throw std::invalid_argument("Missing graph kind (random, grid, geometric, powerlaw or complete)");
+    }
+
+    GeneratorSpec spec;
+    if (kind == "random") spec.kind = GraphKind::Random;
+    else if (kind == "grid") spec.kind = GraphKind::Grid;
+    else if (kind == "geometric") spec.kind = GraphKind::Geometric;
+    else if (kind == "powerlaw") spec.kind = GraphKind::PowerLaw;
+    else if (kind == "complete") spec.kind = GraphKind::Complete;
+    else throw std::invalid_argument("Unknown graph kind '" + kind + "'");
+
+    std::string token;
+    while (in >> token) {
+        size_t eq = token.find('=');
+        if (eq == std::string::npos) {
+            throw std::invalid_argument("Expected key=value, got '" + token + "'");
+        }
+        std::string key = token.substr(0, eq);
+        std::string value = token.substr(eq + 1);
+
+        if (key == "n") spec.vertices = parseInt(key, value);
+        else if (key == "m") spec.edges = parseInteger(key, value);
+        else if (key == "rows") spec.rows = parseInt(key, value);
+        else if (key == "cols") spec.cols = parseInt(key, value);
+        else if (key == "r") spec.radius = parseDouble(key, value);
+        else if (key == "exp") spec.exponent = parseDouble(key, value);
+        else if (key == "deg") spec.averageDegree = parseDouble(key, value);
+        else if (key == "seed") spec.seed = static_cast<uint64_t>(parseInteger(key, value));
+        else if (key == "w") {
+            size_t dots = value.find("..");
+            if (dots == std::string::npos) {
+                spec.minWeight = spec.maxWeight = parseInt(key, value);
+            } else {
+                spec.minWeight = parseInt(key, value.substr(0, dots));
+                spec.maxWeight = parseInt(key, value.substr(dots + 2));
+            }
+        }
+        else throw std::invalid_argument("Unknown key '" + key + "'");
+    }
+
+    if (spec.kind == GraphKind::Grid) {
+        // A square grid of about n vertices unless the shape is given
+        if (spec.rows <= 0 && spec.cols <= 0) {
+            spec.rows = spec.cols = static_cast<int>(std::lround(std::sqrt(static_cast<double>(spec.vertices))));
+        } else if (spec.rows <= 0) {
+            spec.rows = spec.cols > 0 && spec.vertices > 0 ? (spec.vertices + spec.cols - 1) / spec.cols : 1;
+        } else if (spec.cols <= 0) {
+            spec.cols = spec.vertices > 0 ? (spec.vertices + spec.rows - 1) / spec.rows : 1;
+        }
+        long long cells = static_cast<long long>(spec.rows) * spec.cols;
+        if (cells > INT_MAX) {
+            throw std::invalid_argument("Grid of " + std::to_string(cells) + " vertices is too large");
+        }
+        spec.vertices = static_cast<int>(cells);
+    }
+
+    if (spec.vertices < 0) {
+        throw std::invalid_argument("Number of vertices must not be negative");
+    }
+    if (spec.minWeight <= 0 || spec.minWeight > spec.maxWeight) {
+        throw std::invalid_argument("Weight range must be positive and min <= max");
+    }
+    long long maxEdges = static_cast<long long>(spec.vertices) * (spec.vertices - 1) / 2;
+    if (spec.kind == GraphKind::Random && (spec.edges < 0 || spec.edges > maxEdges)) {
+        throw std::invalid_argument("m must be between 0 and n(n-1)/2 = " + std::to_string(maxEdges));
+    }
+    if (spec.kind == GraphKind::PowerLaw && spec.exponent <= 1.0) {
+        throw std::invalid_argument("Power-law exponent must be greater than 1");
+    }
+    return spec;
+}
+
+// Runs rowEdges(u, out) for every vertex in parallel and concatenates the rows in vertex order
+template <typename RowFn>
+static std::vector<std::tuple<int, int, int>> generateRows(int n, ThreadPool& pool, const CancelToken& token,
+                                                           RowFn rowEdges)
+{
+    std::vector<std::vector<std::tuple<int, int, int>>> rows(n);
+    pool.parallelFor(0, n, [&](size_t u) {
+        token.check();
+        rowEdges(static_cast<int>(u), rows[u]);
+    }, ROW_GRAIN);
+
+    size_t total = 0;
+    for (const auto& row : rows) total += row.size();
+    std::vector<std::tuple<int, int, int>> edges;
+    edges.reserve(total);
+    for (auto& row : rows) {
+        edges.insert(edges.end(), row.begin(), row.end());
+    }
+    return edges;
+}
+
+// G(n,m): candidates are drawn in parallel from a counter-based stream, then the first m distinct
+// ones are kept in candidate order
+static std::vector<std::tuple<int, int, int>> generateRandom(const GeneratorSpec& spec, ThreadPool& pool,
+                                                             const CancelToken& token)
+{
+    const uint64_t n = spec.vertices;
+    std::vector<std::tuple<int, int, int>> edges;
+    edges.reserve(spec.edges);
+    std::unordered_set<uint64_t> seen;
+    seen.reserve(spec.edges);
+
+    std::vector<uint64_t> candidates(CANDIDATE_BATCH);
+    uint64_t drawn = 0;
+    while (static_cast<long long>(edges.size()) < spec.edges) {
+        token.check();
+        pool.parallelFor(0, CANDIDATE_BATCH, [&](size_t i) {
+            uint64_t bits = randomOf(spec.seed, CANDIDATE, drawn + i, 0);
+            uint64_t u = (bits & 0xffffffffULL) % n;
+            uint64_t v = (bits >> 32) % n;
+            candidates[i] = std::min(u, v) * n + std::max(u, v);
+        }, 4096);
+        drawn += CANDIDATE_BATCH;
+
+        for (uint64_t key : candidates) {
+            int u = static_cast<int>(key / n);
+            int v = static_cast<int>(key % n);
+            if (u == v || !seen.insert(key).second) continue;
+            edges.emplace_back(u, v, weightOf(spec, u, v));
+            if (static_cast<long long>(edges.size()) == spec.edges) break;
+        }
+    }
+    return edges;
+}
+
+std::vector<std::tuple<int, int, int>> generateEdges(const GeneratorSpec& spec, ThreadPool& pool,
+                                                     const CancelToken& token)
+{
+    const int n = spec.vertices;
+    switch (spec.kind) {
+    case GraphKind::Random:
+        return generateRandom(spec, pool, token);
+
+    case GraphKind::Grid:
+        return generateRows(n, pool, token, [&spec](int u, std::vector<std::tuple<int, int, int>>& out) {
+            int row = u / spec.cols, col = u % spec.cols;
+            if (col + 1 < spec.cols) out.emplace_back(u, u + 1, weightOf(spec, u, u + 1));
+            if (row + 1 < spec.rows) out.emplace_back(u, u + spec.cols, weightOf(spec, u, u + spec.cols));
+        });
+
+    case GraphKind::Complete:
+        return generateRows(n, pool, token, [&spec, n](int u, std::vector<std::tuple<int, int, int>>& out) {
+            for (int v = u + 1; v < n; ++v) out.emplace_back(u, v, weightOf(spec, u, v));
+        });
+
+    case GraphKind::Geometric: {
+        // Weights grow with the distance between the points, within the weight range
+        std::vector<double> x(n), y(n);
+        pool.parallelFor(0, n, [&](size_t u) {
+            x[u] = unitOf(randomOf(spec.seed, POINT, u, 0));
+            y[u] = unitOf(randomOf(spec.seed, POINT, u, 1));
+        }, 4096);
+        double radius2 = spec.radius * spec.radius;
+        return generateRows(n, pool, token, [&](int u, std::vector<std::tuple<int, int, int>>& out) {
+            for (int v = u + 1; v < n; ++v) {
+                double dx = x[u] - x[v], dy = y[u] - y[v];
+                double d2 = dx * dx + dy * dy;
+                if (d2 > radius2) continue;
+                double scaled = spec.radius > 0 ? std::sqrt(d2) / spec.radius : 0.0;
+                int weight = spec.minWeight + static_cast<int>(scaled * (spec.maxWeight - spec.minWeight));
+                out.emplace_back(u, v, weight);
+            }
+        });
+    }
+
+    case GraphKind::PowerLaw: {
+        // Chung-Lu: vertex u gets expected degree proportional to (u+1)^(-1/(exp-1)), and the pair
+        // (u, v) is linked with probability min(1, d_u d_v / sum(d))
+        std::vector<double> degree(n);
+        double sum = 0;
+        for (int u = 0; u < n; ++u) {
+            degree[u] = std::pow(u + 1.0, -1.0 / (spec.exponent - 1.0));
+            sum += degree[u];
+        }
+        double total = spec.averageDegree * n;
+        for (double& d : degree) d *= total / sum;
+        return generateRows(n, pool, token, [&](int u, std::vector<std::tuple<int, int, int>>& out) {
+            for (int v = u + 1; v < n; ++v) {
+                double p = std::min(1.0, degree[u] * degree[v] / total);
+                if (unitOf(randomOf(spec.seed, EDGE, u, v)) < p) out.emplace_back(u, v, weightOf(spec, u, v));
+            }
+        });
+    }
+    }
+    return {};
+}
+
+Graph generateGraph(const GeneratorSpec& spec, ThreadPool& pool, const CancelToken& token)
+{
+    std::vector<std::tuple<int, int, int>> edges = generateEdges(spec, pool, token);
+    Graph graph(spec.vertices);
+    for (size_t i = 0; i < edges.size(); ++i) {
+        if (i % INSERT_BATCH == 0) token.check();
+        const auto& [u, v, weight] = edges[i];
+        graph.addEdge(u, v, weight);
+    }
+    return graph;
+}
@@ -0,0 +1,57 @@
+#ifndef GENERATOR_HPP
+#define GENERATOR_HPP
+
+#include "cancel.hpp"
+#include "graph.hpp"
+#include "parallel.hpp"
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+enum class GraphKind {
+    Random,     // G(n,m): m distinct edges chosen uniformly at random
+    Grid,       // rows x cols lattice, each vertex linked to its right and lower neighbour
+    Geometric,  // n random points in the unit square, linked when closer than radius
+    PowerLaw,   // Chung-Lu graph with a power-law expected degree sequence
+    Complete    // Every pair of vertices
+};
+
+/**
+ * Struct: GeneratorSpec
+ * Compact description of a synthetic graph, written as
+ *   <kind> key=value ...
+ * e.g. "random n=1000 m=5000 w=1..100 seed=7" or "grid rows=30 cols=40".
+ * Keys: n, m (random), rows and cols (grid), r (geometric radius), exp and deg (power-law
+ * exponent and average degree), w=min..max (weight range) and seed.
+ */
+struct GeneratorSpec {
+    GraphKind kind = GraphKind::Random;
+    int vertices = 0;
+    long long edges = 0;
+    int rows = 0;
+    int cols = 0;
+    double radius = 0.1;
+    double exponent = 2.5;
+    double averageDegree = 4.0;
+    int minWeight = 1;
+    int maxWeight = 100;
+    uint64_t seed = 1;
+};
+
+// Parses a spec; throws std::invalid_argument on unknown kinds or keys and on bad values
+GeneratorSpec parseGeneratorSpec(const std::string& text);
+
+// Edges (u, v, weight) with u < v of the described graph. Generation runs in parallel, but every
+// random decision is a pure function of the seed and the vertex pair, so the result only depends
+// on the spec, never on the number of threads or on scheduling. The token is polled once per
+// vertex row (per candidate batch for random graphs); a cancelled token throws Cancelled.
+std::vector<std::tuple<int, int, int>> generateEdges(const GeneratorSpec& spec, ThreadPool& pool = ThreadPool::shared(),
+                                                     const CancelToken& token = CancelToken());
+
+// The described graph
+Graph generateGraph(const GeneratorSpec& spec, ThreadPool& pool = ThreadPool::shared(),
+                    const CancelToken& token = CancelToken());
+
+#endif // GENERATOR_HPP
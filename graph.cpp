@@ -1,14 +1,29 @@
 #include "graph.hpp"
+#include "trace.hpp"
+#include <atomic>
 #include <stdexcept> // For exceptions
 
 // Constructor
 Graph::Graph(int vertices) : vertexCount(vertices), edgeCount(0) {
+    TRACE_SPAN("graph.allocate");
     // Initialize the adjacency matrix with zeros
-    adjMatrix.resize(vertices, vector<int>(vertices, 0));
+    adjMatrix.reserve(vertices);
+    for (int u = 0; u < vertices; u++) {
+        adjMatrix.push_back(std::make_shared<vector<int>>(vertices, 0));
+    }
 }
 Graph::Graph() : vertexCount(0), edgeCount(0) {
-    // Initialize the adjacency matrix with zeros
-    adjMatrix.resize(0, vector<int>(0, 0));
+}
+
+// Returns row u for writing, copying it first unless this graph is its only owner
+vector<int>& Graph::writableRow(int u) {
+    if (adjMatrix[u].use_count() == 1) {
+        // Pairs with the release of the last other owner, whose reads of the row must finish first
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } else {
+        adjMatrix[u] = std::make_shared<vector<int>>(*adjMatrix[u]);
+    }
+    return *adjMatrix[u];
 }
 
 // Function to add an edge between vertices u and v with a given weight
@@ -20,11 +35,11 @@ void Graph::addEdge(int u, int v, int weight) {
         throw std::invalid_argument("Weight must be positive");
     }
     // Add the weight to the adjacency matrix
-    if (adjMatrix[u][v] == 0) {
+    if ((*adjMatrix[u])[v] == 0) {
         edgeCount++; // Only increment edge count if the edge is new
     }
-    adjMatrix[u][v] = weight;
-    adjMatrix[v][u] = weight; // For undirected graph
+    writableRow(u)[v] = weight;
+    writableRow(v)[u] = weight; // For undirected graph
 }
 
 // Function to remove an edge between vertices u and v
@@ -32,9 +47,9 @@ void Graph::removeEdge(int u, int v) {
     if (u < 0 || u >= vertexCount || v < 0 || v >= vertexCount) {
         throw std::out_of_range("Vertex index out of range");
     }
-    if (adjMatrix[u][v] != 0) {
-        adjMatrix[u][v] = 0;
-        adjMatrix[v][u] = 0; // For undirected graph
+    if ((*adjMatrix[u])[v] != 0) {
+        writableRow(u)[v] = 0;
+        writableRow(v)[u] = 0; // For undirected graph
         edgeCount--; // Decrement edge count
     }
 }
@@ -49,7 +64,18 @@ int Graph::getEdgeCount() const {
     return edgeCount;
 }
 
+// Getter for one row of the adjacency matrix
+const vector<int>& Graph::row(int u) const {
+    return *adjMatrix[u];
+}
+
 // Getter for the adjacency matrix
 vector<vector<int>> Graph::getGraph() const {
-    return adjMatrix;
+    TRACE_SPAN("graph.getGraph");
+    vector<vector<int>> matrix;
+    matrix.reserve(vertexCount);
+    for (const auto& row : adjMatrix) {
+        matrix.push_back(*row);
+    }
+    return matrix;
 }
@@ -1,10 +1,17 @@
 #ifndef GRAPH_HPP
 #define GRAPH_HPP
 
+#include <memory>
 #include <vector>
 
 using std::vector;
 
+/**
+ * Class: Graph
+ * Undirected weighted graph stored as an adjacency matrix. Copies share their rows and a row is
+ * copied only when a graph sharing it is written, so copying a graph costs one pointer per
+ * vertex and each later edit copies at most the two rows it touches.
+ */
 class Graph {
 public:
     // Constructor
@@ -19,12 +26,18 @@ public:
     // Getters
     int getVertexCount() const;
     int getEdgeCount() const;
+    // Row u of the adjacency matrix, read in place; valid while this graph is alive and unchanged
+    const vector<int>& row(int u) const;
+    // Full copy of the adjacency matrix, O(n^2); readers that do not keep it should use row()
     vector<vector<int>> getGraph() const;
 
 private:
+    // Row u, copied first if another graph still shares it
+    vector<int>& writableRow(int u);
+
     int vertexCount;
     int edgeCount;
-    vector<vector<int>> adjMatrix; // Adjacency matrix to store weights of edges
+    vector<std::shared_ptr<vector<int>>> adjMatrix; // Adjacency matrix to store weights of edges
 };
 
 #endif // GRAPH_HPP
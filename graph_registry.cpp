@@ -0,0 +1,87 @@
+#include "graph_registry.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+// Constructor: publishes an empty graph as version 0
+SharedGraph::SharedGraph(int vertices)
+{
+    if (vertices < 0) {
+        throw std::invalid_argument("Number of vertices must not be negative");
+    }
+    current.store(std::make_shared<const GraphSnapshot>(GraphSnapshot{Graph(vertices), 0}));
+}
+
+SharedGraph::SharedGraph(Graph initial)
+{
+    current.store(std::make_shared<const GraphSnapshot>(GraphSnapshot{std::move(initial), 0}));
+}
+
+std::shared_ptr<const GraphSnapshot> SharedGraph::snapshot() const
+{
+    return current.load(std::memory_order_acquire);
+}
+
+std::shared_ptr<const GraphSnapshot> SharedGraph::update(const std::function<void(Graph&)>& mutate)
+{
+    std::lock_guard<std::mutex> lock(writerMutex);
+    std::shared_ptr<const GraphSnapshot> old = current.load(std::memory_order_acquire);
+
+    // Copy (sharing the rows), mutate the private copy, then publish it
+    auto next = std::make_shared<GraphSnapshot>(GraphSnapshot{old->graph, old->version + 1});
+    mutate(next->graph);
+    std::shared_ptr<const GraphSnapshot> published = std::move(next);
+    current.store(published, std::memory_order_release);
+    return published;
+}
+
+std::shared_ptr<const GraphSnapshot> SharedGraph::addEdge(int u, int v, int weight)
+{
+    return update([u, v, weight](Graph& graph) { graph.addEdge(u, v, weight); });
+}
+
+std::shared_ptr<const GraphSnapshot> SharedGraph::removeEdge(int u, int v)
+{
+    return update([u, v](Graph& graph) { graph.removeEdge(u, v); });
+}
+
+std::shared_ptr<SharedGraph> GraphRegistry::create(const std::string& name, int vertices)
+{
+    auto graph = std::make_shared<SharedGraph>(vertices);
+    add(name, graph);
+    return graph;
+}
+
+void GraphRegistry::add(const std::string& name, std::shared_ptr<SharedGraph> graph)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (!graphs.emplace(name, std::move(graph)).second) {
+        throw std::invalid_argument("Graph '" + name + "' already exists");
+    }
+}
+
+std::shared_ptr<SharedGraph> GraphRegistry::find(const std::string& name) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = graphs.find(name);
+    return it == graphs.end() ? nullptr : it->second;
+}
+
+bool GraphRegistry::remove(const std::string& name)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    return graphs.erase(name) > 0;
+}
+
+std::vector<std::string> GraphRegistry::names() const
+{
+    std::vector<std::string> result;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        for (const auto& entry : graphs) {
+            result.push_back(entry.first);
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
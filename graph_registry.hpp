@@ -0,0 +1,76 @@
+#ifndef GRAPH_REGISTRY_HPP
+#define GRAPH_REGISTRY_HPP
+
+#include "graph.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Immutable published state of a shared graph
+struct GraphSnapshot {
+    Graph graph;
+    uint64_t version;   // Incremented by every published update
+};
+
+/**
+ * Class: SharedGraph
+ * A graph that many connections read and mutate concurrently, RCU style.
+ * Readers take the current snapshot with a single atomic load and keep it for as long
+ * as they need; a snapshot never changes once published. Writers copy the current
+ * snapshot, apply their change and publish the copy with an atomic store, so they never
+ * wait for readers. The copy shares the matrix rows of the snapshot (see Graph), so an
+ * edge update costs O(n) rather than O(n^2). A superseded snapshot is freed when its last
+ * reader drops it.
+ */
+class SharedGraph {
+public:
+    explicit SharedGraph(int vertices);
+    // Publishes an already built graph as version 0
+    explicit SharedGraph(Graph initial);
+
+    // Current snapshot; never blocks on writers
+    std::shared_ptr<const GraphSnapshot> snapshot() const;
+
+    // Applies mutate to a copy of the current graph and publishes it. Writers are
+    // serialized among themselves only. If mutate throws nothing is published.
+    std::shared_ptr<const GraphSnapshot> update(const std::function<void(Graph&)>& mutate);
+
+    std::shared_ptr<const GraphSnapshot> addEdge(int u, int v, int weight);
+    std::shared_ptr<const GraphSnapshot> removeEdge(int u, int v);
+
+private:
+    std::atomic<std::shared_ptr<const GraphSnapshot>> current;
+    std::mutex writerMutex;
+};
+
+/**
+ * Class: GraphRegistry
+ * Server-wide table of named graphs, so a graph uploaded once can be attached to, queried
+ * and mutated from any connection. The table lock only guards name lookups; graph data is
+ * accessed through the SharedGraph snapshots.
+ */
+class GraphRegistry {
+public:
+    // Creates a new named graph; throws std::invalid_argument if the name is taken
+    std::shared_ptr<SharedGraph> create(const std::string& name, int vertices);
+    // Registers an existing graph under name; throws std::invalid_argument if the name is taken
+    void add(const std::string& name, std::shared_ptr<SharedGraph> graph);
+    // Named graph, or nullptr if there is none
+    std::shared_ptr<SharedGraph> find(const std::string& name) const;
+    // Removes the name; connections attached to the graph keep using it
+    bool remove(const std::string& name);
+    std::vector<std::string> names() const;
+
+private:
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<SharedGraph>> graphs;
+};
+
+#endif // GRAPH_REGISTRY_HPP
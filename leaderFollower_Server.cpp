@@ -9,127 +9,100 @@
 #include <unistd.h>
 #include <sstream>
 #include <functional>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <chrono>
 #include "graph.hpp"
 #include "mst.hpp"
+#include "reactor.hpp"
+#include "session.hpp"
+#include "graph_registry.hpp"
+#include "affinity.hpp"
+#include "trace.hpp"
+#include "parallel.hpp"
 #include <csignal>
 
 #define PORT 8094
-#define THREAD_POOL_SIZE 4
+#define UNIX_SOCKET "/tmp/mst_lf.sock" // Default Unix-domain socket for clients on the same host
+#define THREAD_POOL_SIZE 4 // Fallback when the number of cores cannot be detected
 
 bool close_server = false;
 
 class LeaderFollowerServer {
 private:
-    struct Task {
-        int newSocket;
-    };
+    using Job = std::function<void()>;
 
+    Reactor& reactor;                   // Event loop that drives the client sessions
+    GraphRegistry& registry;            // Named graphs shared by all connections
+    ThreadPool pool;                    // Data-parallel helpers of the jobs, run by this shard's workers
+    SessionStages stages;               // All session work goes to this pool
+    std::chrono::milliseconds deadline; // Default time limit of a command, zero for none
     std::vector<std::thread> workers;      
-    std::queue<Task> tasks;                
+    std::queue<Job> tasks;                
     std::mutex queueMutex;               
     std::condition_variable cv;         
     bool stopFlag;                      
          
-    Graph build_graph(int newSocket)
-    {
-        std::string response = "----------Graph creation----------\nEnter the number of vertices: ";
-        send(newSocket, response.c_str(), response.size(), 0);
-
-        char answer[1024] = {0};
-        read(newSocket, answer, 1024);
-        int numVertices = std::stoi(answer);
-
-        // Create a new graph with the given number of vertices
-        Graph graph = Graph(numVertices); 
-
-        response = "Enter the number of edges: ";
-        send(newSocket, response.c_str(), response.size(), 0);
-
-        answer[1024] = {0};
-        read(newSocket, answer, 1024);
-        int numEdges = std::stoi(answer);
-
-        // Add edges to the graph
-        for (int i = 0; i < numEdges; ++i)
-        {
-            response = "Enter an edge (from, to, weight): ";
-            send(newSocket, response.c_str(), response.size(), 0);
-
-            int from, to, weight;
-            char edgeBuffer[1024] = {0};
-            read(newSocket, edgeBuffer, 1024);
-            std::istringstream edgeStream(edgeBuffer);
-            edgeStream >> from >> to >> weight;
-            graph.addEdge(from, to, weight);
-            std::string response = "Edge from " + std::to_string(from) + " -> " + std::to_string(to) +" with weight " + std::to_string(weight) + " added successfully!\n";
-            send(newSocket, response.c_str(), response.size(), 0);
+    // One client session. Runs on the reactor thread and suspends while waiting for the client
+    Task<void> processClient(int newSocket) {
+        Connection conn(reactor, newSocket);
+        ClientSession session(conn, registry, stages, deadline);
+        try {
+            co_await session.run();
+        } catch (const std::exception& e) {
+            std::cerr << "Client session failed: " << e.what() << "\n";
         }
-        response = "New graph created!\n";
-        send(newSocket, response.c_str(), response.size(), 0);
-
-        return graph;
     }
 
-    MST build_mst(Graph graph, int newSocket)
-    {
-        std::string response = "----------MST creation----------\nEnter the algorithm of MST (prim or boruvka): ";
-        send(newSocket, response.c_str(), response.size(), 0);
-
-        char algoBuffer[1024] = {0};
-        read(newSocket, algoBuffer, 1024);
-        std::string algo(algoBuffer);
-
-        // Trim whitespace and newline characters
-        // algo.erase(algo.find_last_not_of(" \t\n\r") + 1);
-
-        MST mst = MST(graph.getGraph(), graph.getVertexCount(), algo); // Create the MST
-        response = "MST created using " + algo + " algorithm\n";
-        send(newSocket, response.c_str(), response.size(), 0);
-
-        return mst;
-    }
-
-    void analyze_data(MST mst, int newSocket)
-    {
-        std::stringstream ss;
-
-        ss << "----------analyze_data----------\n";
-        ss << "Total Weight:  " << mst.getTotalWeight() << "\n";
-        ss << "Longest Distance (e.g. 0->1):  " << mst.getLongestDistance(0, 1) << "\n";
-        ss << "Shortest Distance (e.g. 0->1):  " << mst.getShortestDistance(0, 1) << "\n";
-        ss << "Average Edge Count:  " << mst.getAverageEdgeCount() << "\n";
-
-        send(newSocket, (ss.str()).c_str(), (ss.str()).size(), 0);
-    }
-
-    void processClient(int newSocket) {
-        Graph graph = build_graph(newSocket);
-        MST mst = build_mst(newSocket, newSocket);
-        analyze_data(mst, newSocket);
-        close(newSocket);
+    // The cores of the shard whose workers start at firstWorker
+    static CpuSet shardCpus(const CpuSet& workerCpus, size_t firstWorker, size_t poolSize) {
+        CpuSet cpus;
+        for (size_t i = 0; i < poolSize && !workerCpus.empty(); ++i) {
+            cpus.push_back(workerCpus[(firstWorker + i) % workerCpus.size()]);
+        }
+        return cpus;
     }
 
-    void workerLoop() {
+    // cpus: the single core this worker is pinned to, or empty to let it float
+    void workerLoop(const CpuSet& cpus) {
+        TRACE_THREAD("worker");
+        try {
+            placeCurrentThread(cpus);
+        } catch (const std::exception& e) {
+            std::cerr << "Worker runs unpinned: " << e.what() << "\n";
+        }
         while (true) {
-            Task task;
+            Job task;
             {
                 std::unique_lock<std::mutex> lock(queueMutex);
                 cv.wait(lock, [this]() { return !tasks.empty() || stopFlag; });
                 if (stopFlag && tasks.empty()) return;
-                task = tasks.front();
+                task = std::move(tasks.front());
                 tasks.pop();
             }
-            processClient(task.newSocket);
+            TRACE_SPAN("worker.job");
+            task();
         }
     }
 
 public:
-    LeaderFollowerServer(size_t poolSize) : stopFlag(false) {                  
+    // Worker i is pinned to workerCpus[(firstWorker + i) % size], so shards given consecutive
+    // firstWorker values spread over the cores; an empty workerCpus leaves the workers unpinned
+    LeaderFollowerServer(Reactor& reactor, GraphRegistry& registry, size_t poolSize, std::chrono::milliseconds deadline,
+                         const CpuSet& workerCpus, size_t firstWorker)
+        : reactor(reactor), registry(registry), pool([this](Job job) { post(std::move(job)); }, poolSize),
+        stages{Executor::of(*this), Executor::of(*this), Executor::of(*this), pool}, deadline(deadline), stopFlag(false) {                  
         // this for loop is for creating the threads
+        CpuSet ownCpus = shardCpus(workerCpus, firstWorker, poolSize);
         for (size_t i = 0; i < poolSize; ++i) {
+            CpuSet cpus;
+            if (!ownCpus.empty()) {
+                cpus.push_back(ownCpus[i]);
+            }
             // create a new thread and push it to the workers vector
             // each thread will run the workerLoop function forever and search for tasks
-            workers.emplace_back([this]() { this->workerLoop(); });
+            workers.emplace_back([this, cpus]() { this->workerLoop(cpus); });
         }
     }
 
@@ -144,60 +117,145 @@ public:
         }
     }
 
-    void addTask(int newSocket) {
+    // Queues a compute job for the worker pool
+    void post(Job job) {
         {
             std::unique_lock<std::mutex> lock(queueMutex);
-            tasks.push(Task{newSocket});
+            tasks.push(std::move(job));
         }
         cv.notify_one();
     }
+
+    // Accepts clients forever, starting a session coroutine for each of them
+    Task<void> acceptLoop(int serverFd) {
+        while (!close_server) {
+            int newSocket = co_await reactor.accept(serverFd);
+            spawn(processClient(newSocket));
+        }
+        reactor.stop();
+    }
 };
 
-int main() {
-    int serverFd, newSocket;
-    struct sockaddr_in address;
-    int addrlen = sizeof(address);
-    int opt = 1;
+/**
+ * Struct: Shard
+ * One acceptor: a listening socket, the reactor that accepts on it and runs its sessions, and a
+ * worker pool of its own. Shards share nothing but the graph registry, so they never contend
+ * on a queue lock.
+ */
+struct Shard {
+    int serverFd;
+    Reactor reactor;
+    LeaderFollowerServer server;
+
+    Shard(int serverFd, GraphRegistry& registry, size_t poolSize, std::chrono::milliseconds deadline,
+          const CpuSet& workerCpus, size_t firstWorker)
+        : serverFd(serverFd), server(reactor, registry, poolSize, deadline, workerCpus, firstWorker) {}
+    ~Shard() { close(serverFd); }
+};
 
-    if ((serverFd = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
-        std::cerr << "Socket creation failed\n";
-        return -1;
+// Whole-string integer value of a command-line option; throws invalid_argument naming the option
+static int parseNumber(const std::string& option, const std::string& text) {
+    size_t used = 0;
+    int value = 0;
+    try {
+        value = std::stoi(text, &used);
+    } catch (const std::exception&) {
+        used = 0;
     }
-
-    if (setsockopt(serverFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt))) {
-        std::cerr << "setsockopt failed\n";
-        close(serverFd);
-        return -1;
+    if (used == 0 || used != text.size()) {
+        throw std::invalid_argument(option + " needs a number, got '" + text + "'");
     }
+    return value;
+}
 
-    address.sin_family = AF_INET;
-    address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(PORT);
-
-    if (bind(serverFd, (struct sockaddr*)&address, sizeof(address)) < 0) {
-        std::cerr << "Bind failed\n";
-        close(serverFd);
+int main(int argc, char* argv[]) {
+    // --acceptors N: N acceptor threads, each with its own SO_REUSEPORT socket on PORT
+    // --deadline-ms MS: default time limit of every command's computation (0, the default, for none)
+    // --worker-cpus LIST: one worker per core of LIST (e.g. 0-7), each pinned to its core
+    // --unix PATH: also accept local clients on this Unix-domain socket (default UNIX_SOCKET)
+    // --no-unix: TCP only
+    size_t acceptors = 1;
+    std::string unixPath = UNIX_SOCKET;
+    std::chrono::milliseconds deadline(0);
+    CpuSet workerCpus;
+    const char* usage = " [--acceptors N] [--deadline-ms MS] [--worker-cpus LIST] [--unix PATH | --no-unix]\n";
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--acceptors" && i + 1 < argc) {
+                acceptors = std::max(1, parseNumber(arg, argv[++i]));
+            } else if (arg == "--deadline-ms" && i + 1 < argc) {
+                deadline = std::chrono::milliseconds(std::max(0, parseNumber(arg, argv[++i])));
+            } else if (arg == "--worker-cpus" && i + 1 < argc) {
+                workerCpus = parseCpuSet(argv[++i]);
+                checkCpuSet(workerCpus);
+            } else if (arg == "--unix" && i + 1 < argc) {
+                unixPath = argv[++i];
+            } else if (arg == "--no-unix") {
+                unixPath.clear();
+            } else {
+                std::cerr << "Usage: " << argv[0] << usage;
+                return -1;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\nUsage: " << argv[0] << usage;
         return -1;
     }
 
-    if (listen(serverFd, 3) < 0) {
-        std::cerr << "Listen failed\n";
-        close(serverFd);
+    // Sessions live on the reactors; the pools only run MST work, so they are sized by cores
+    // (the pinned cores when --worker-cpus is given)
+    size_t cores = workerCpus.empty() ? std::thread::hardware_concurrency() : workerCpus.size();
+    if (cores == 0) cores = THREAD_POOL_SIZE;
+    size_t poolSize = std::max<size_t>(1, cores / acceptors);
+
+    GraphRegistry registry;
+    std::vector<std::unique_ptr<Shard>> shards;
+    int unixFd = -1;
+    try {
+        for (size_t i = 0; i < acceptors; ++i) {
+            shards.push_back(std::make_unique<Shard>(listenOn(PORT, acceptors > 1), registry, poolSize, deadline,
+                                                     workerCpus, i * poolSize));
+        }
+        if (!unixPath.empty()) {
+            unixFd = listenUnix(unixPath);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
         return -1;
     }
+    std::cout << "Server running with " << acceptors << " acceptor(s) and " << poolSize << " worker threads each...\n";
+    if (!workerCpus.empty()) {
+        std::cout << "Workers pinned to cores " << describeCpuSet(workerCpus) << "\n";
+    }
+    if (unixFd >= 0) {
+        std::cout << "Local clients on " << unixPath << "\n";
+    }
 
-    // Create the server with a thread pool size of 4
-    LeaderFollowerServer server(THREAD_POOL_SIZE);
-    std::cout << "Server running...\n";
-
-    while ((newSocket = accept(serverFd, (struct sockaddr*)&address, (socklen_t*)&addrlen)) >= 0) {
-        server.addTask(newSocket);
-        if (close_server) {
-            close(serverFd);
-            return 0;
-        }
+    // Start accepting before the reactors run: spawn registers the listening socket with the
+    // reactor, which must not happen concurrently with its loop
+    for (auto& shard : shards) {
+        spawn(shard->server.acceptLoop(shard->serverFd));
     }
+    // Local clients are few and light on the reactor: the first shard serves them as well
+    if (unixFd >= 0) {
+        spawn(shards[0]->server.acceptLoop(unixFd));
+    }
+    std::vector<std::thread> acceptorThreads;
+    for (size_t i = 1; i < shards.size(); ++i) {
+        acceptorThreads.emplace_back([&shard = *shards[i]]() { shard.reactor.run(); });
+    }
+    shards[0]->reactor.run();
 
-    close(serverFd);
+    for (auto& shard : shards) {
+        shard->reactor.stop();
+    }
+    for (auto& thread : acceptorThreads) {
+        thread.join();
+    }
+    if (unixFd >= 0) {
+        close(unixFd);
+        unlink(unixPath.c_str());
+    }
     return 0;
 }
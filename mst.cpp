@@ -1,24 +1,29 @@
 #include "mst.hpp"
 #include "prim.hpp"      // Include the Prim's algorithm header
 #include "boruvka.hpp"    // Include the Boruvka's algorithm header
+#include "forest.hpp"     // Include the parallel spanning forest header
+#include "trace.hpp"      // Include the phase tracing macros
 #include <limits>
 #include <queue>
 #include <string>
+#include <stdexcept>
 #include <iostream>
 
 // Constructor
-MST::MST(const std::vector<std::vector<int>>& graph, int n, const std::string& algo) : graph(graph), numVertices(n) 
+MST::MST(const Graph& graph, const std::string& algo, const CancelToken& token)
+    : numVertices(graph.getVertexCount()), graph(graph)
 {
+    TRACE_SPAN("mst.construct");
     if (algo == "prim") {
-        calculateMSTUsingPrim();
+        calculateMSTUsingPrim(token);
     } else if (algo == "boruvka") {
-        calculateMSTUsingBoruvka();
+        calculateMSTUsingBoruvka(token);
     }
 }
 
 // Function to calculate MST using Prim's algorithm
-void MST::calculateMSTUsingPrim() {
-    mstEdges = prim(convertGraphToEdges(), numVertices);
+void MST::calculateMSTUsingPrim(const CancelToken& token) {
+    mstEdges = prim(convertGraphToEdges(token), numVertices, token);
 }
 
 // Public function to retrieve MST edges using Prim's algorithm
@@ -28,8 +33,8 @@ std::vector<std::tuple<int, int, int, int>> MST::primMST() {
 }
 
 // Function to calculate MST using Boruvka's algorithm
-void MST::calculateMSTUsingBoruvka() {
-    mstEdges = boruvka(convertGraphToEdges(), numVertices);
+void MST::calculateMSTUsingBoruvka(const CancelToken& token) {
+    mstEdges = boruvka(convertGraphToEdges(token), numVertices, token);
 }
 
 // Public function to retrieve MST edges using Boruvka's algorithm
@@ -38,6 +43,14 @@ std::vector<std::tuple<int, int, int, int>> MST::boruvkaMST() {
     return mstEdges;
 }
 
+// Function to calculate the spanning forest component by component
+SpanningForest MST::spanningForest(const std::string& algo, ThreadPool& pool, const CancelToken& token) {
+    TRACE_SPAN("mst.spanningForest");
+    SpanningForest forest = ::spanningForest(convertGraphToEdges(token), numVertices, algo, pool, token);
+    mstEdges = forest.edges;
+    return forest;
+}
+
 // Function to get the total weight of the MST
 int MST::getTotalWeight() {
     int totalWeight = 0;
@@ -48,12 +61,15 @@ int MST::getTotalWeight() {
 }
 
 // Helper function to convert graph representation to edges
-std::vector<std::tuple<int, int, int, int>> MST::convertGraphToEdges() {
+std::vector<std::tuple<int, int, int, int>> MST::convertGraphToEdges(const CancelToken& token) {
+    TRACE_SPAN("mst.convertGraphToEdges");
     std::vector<std::tuple<int, int, int, int>> edges;
     for (int u = 0; u < numVertices; ++u) {
+        token.check();
+        const std::vector<int>& row = graph.row(u);
         for (int v = u + 1; v < numVertices; ++v) { // Avoid duplicate edges
-            if (graph[u][v] > 0) { // Only consider edges with positive weight
-                edges.emplace_back(u, v, graph[u][v], edges.size());
+            if (row[v] > 0) { // Only consider edges with positive weight
+                edges.emplace_back(u, v, row[v], edges.size());
             }
         }
     }
@@ -61,19 +77,25 @@ std::vector<std::tuple<int, int, int, int>> MST::convertGraphToEdges() {
 }
 
 // Function to find the longest distance between two vertices u and v in the MST
-int MST::getLongestDistance(int u, int v) {
+int MST::getLongestDistance(int u, int v, const CancelToken& token) {
+    TRACE_SPAN("analysis.getLongestDistance");
+    if (u < 0 || u >= numVertices || v < 0 || v >= numVertices) {
+        throw std::out_of_range("Vertex index out of range");
+    }
     std::vector<int> dist(numVertices, -std::numeric_limits<int>::max());
     std::queue<int> q;
     dist[u] = 0;
     q.push(u);
 
     while (!q.empty()) {
+        token.check();
         int current = q.front();
         q.pop();
         
+        const std::vector<int>& row = graph.row(current);
         for (int neighbor = 0; neighbor < numVertices; ++neighbor) {
-            if (graph[current][neighbor] > 0 && dist[neighbor] == -std::numeric_limits<int>::max()) {
-                dist[neighbor] = dist[current] + graph[current][neighbor];
+            if (row[neighbor] > 0 && dist[neighbor] == -std::numeric_limits<int>::max()) {
+                dist[neighbor] = dist[current] + row[neighbor];
                 q.push(neighbor);
             }
         }
@@ -83,16 +105,26 @@ int MST::getLongestDistance(int u, int v) {
 }
 
 // Function to calculate the average edge count in all paths between two vertices u and v
-double MST::getAverageEdgeCount() {
+double MST::getAverageEdgeCount(const CancelToken& token) {
+    TRACE_SPAN("analysis.getAverageEdgeCount");
     // מספר הקודקודים בגרף
     const int INF = std::numeric_limits<int>::max();
-    int totalDistance = 0;
+    long long totalDistance = 0;
     int pairCount = 0;
 
     // נבצע אלגוריתם פלויד-וורשל למציאת המרחקים הקצרים ביותר
-    std::vector<std::vector<int>> shortestPaths = graph;
+    // A zero in the matrix means no edge: start those pairs at INF, not at distance 0
+    std::vector<std::vector<int>> shortestPaths(numVertices);
+    for (int i = 0; i < numVertices; ++i) {
+        shortestPaths[i] = graph.row(i);
+        for (int j = 0; j < numVertices; ++j) {
+            if (i != j && shortestPaths[i][j] == 0) shortestPaths[i][j] = INF;
+        }
+        shortestPaths[i][i] = 0;
+    }
 
     for (int k = 0; k < numVertices; ++k) {
+        token.check();
         for (int i = 0; i < numVertices; ++i) {
             for (int j = 0; j < numVertices; ++j) {
                 if (shortestPaths[i][k] < INF && shortestPaths[k][j] < INF) {
@@ -118,7 +150,11 @@ double MST::getAverageEdgeCount() {
 
 
 // Function to find the shortest distance between two vertices u and v in the MST
-int MST::getShortestDistance(int u, int v) {
+int MST::getShortestDistance(int u, int v, const CancelToken& token) {
+    TRACE_SPAN("analysis.getShortestDistance");
+    if (u < 0 || u >= numVertices || v < 0 || v >= numVertices) {
+        throw std::out_of_range("Vertex index out of range");
+    }
     std::vector<int> dist(numVertices, std::numeric_limits<int>::max());
     std::queue<int> q;
 
@@ -126,12 +162,14 @@ int MST::getShortestDistance(int u, int v) {
     q.push(u);
 
     while (!q.empty()) {
+        token.check();
         int current = q.front();
         q.pop();
 
+        const std::vector<int>& row = graph.row(current);
         for (int neighbor = 0; neighbor < numVertices; ++neighbor) {
-            if (graph[current][neighbor] > 0 && dist[neighbor] == std::numeric_limits<int>::max()) {
-                dist[neighbor] = dist[current] + graph[current][neighbor];
+            if (row[neighbor] > 0 && dist[neighbor] == std::numeric_limits<int>::max()) {
+                dist[neighbor] = dist[current] + row[neighbor];
                 q.push(neighbor);
             }
         }
@@ -139,3 +177,16 @@ int MST::getShortestDistance(int u, int v) {
 
     return dist[v] == std::numeric_limits<int>::max() ? -1 : dist[v];
 }
+
+// Function to create a sampler estimating the distances of the graph
+DistanceSampler MST::distanceSampler(uint64_t seed, ThreadPool& pool) const {
+    return DistanceSampler(graph, seed, pool);
+}
+
+// Function to answer a batch of path queries on the MST with one shared index
+std::vector<PairAnswer> MST::queryPairs(const std::vector<std::pair<int, int>>& pairs, ThreadPool& pool,
+                                        const CancelToken& token) {
+    TRACE_SPAN("analysis.queryPairs");
+    PathIndex index(mstEdges, numVertices);
+    return index.queryAll(pairs, pool, token);
+}
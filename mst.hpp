@@ -4,35 +4,61 @@
 #include <vector>
 #include <tuple>
 #include <string>
+#include <utility>
+#include "cancel.hpp"
+#include "distance_sampler.hpp"
+#include "graph.hpp"
+#include "parallel.hpp"
+#include "path_index.hpp"
+
+struct SpanningForest;
 
 class MST {
 public:
-    // Constructor
-    MST(const std::vector<std::vector<int>>& graph, int n, const std::string& algo);
+    // Constructor. The token only applies to the MST computation done by the constructor;
+    // the long-running functions below take their own token. The MST keeps a copy of graph,
+    // which shares the adjacency rows with it (see Graph) instead of copying the matrix.
+    MST(const Graph& graph, const std::string& algo, const CancelToken& token = CancelToken());
     // Constructor without algorithm
-    MST(const std::vector<std::vector<int>>& graph, int n): graph(graph), numVertices(n) {}
-    MST() : graph(), numVertices(0) {}
+    MST(const Graph& graph): numVertices(graph.getVertexCount()), graph(graph) {}
+    MST() : numVertices(0), graph() {}
 
 
     // MST calculation functions
     std::vector<std::tuple<int, int, int, int>> boruvkaMST();
     std::vector<std::tuple<int, int, int, int>> primMST();
+    // Minimum spanning forest of a possibly disconnected graph, computed per component in
+    // parallel on pool, with per-component analytics. The forest becomes this MST's edge set.
+    SpanningForest spanningForest(const std::string& algo, ThreadPool& pool = ThreadPool::shared(),
+                                  const CancelToken& token = CancelToken());
+
+    int getVertexCount() const { return numVertices; }
+    // Edges of the last computed MST (or spanning forest)
+    const std::vector<std::tuple<int, int, int, int>>& getEdges() const { return mstEdges; }
 
-    // Analysis functions
+    // Analysis functions (a cancelled token makes them throw Cancelled)
     int getTotalWeight();
-    int getLongestDistance(int u, int v);        // Longest distance between two vertices u and v
-    double getAverageEdgeCount();    // Average between all pairs of vertices
-    int getShortestDistance(int u, int v);       // Shortest distance between two vertices u and v
+    int getLongestDistance(int u, int v, const CancelToken& token = CancelToken());   // Longest distance between two vertices u and v
+    double getAverageEdgeCount(const CancelToken& token = CancelToken());             // Average between all pairs of vertices
+    int getShortestDistance(int u, int v, const CancelToken& token = CancelToken());  // Shortest distance between two vertices u and v
+    // Sampling estimate of the average and longest distance, for graphs too large for
+    // getAverageEdgeCount; call step() on the sampler until the estimate is good enough
+    DistanceSampler distanceSampler(uint64_t seed = 1, ThreadPool& pool = ThreadPool::shared()) const;
+    // Path distance, hop count and heaviest edge in the MST for a whole batch of vertex pairs,
+    // answered in parallel on pool
+    std::vector<PairAnswer> queryPairs(const std::vector<std::pair<int, int>>& pairs,
+                                       ThreadPool& pool = ThreadPool::shared(),
+                                       const CancelToken& token = CancelToken());
 
 private:
     int numVertices;
-    std::vector<std::vector<int>> graph;         // Graph representation
+    Graph graph;                                  // Graph representation
     std::vector<std::tuple<int, int, int, int>> mstEdges; // Holds the MST edges
 
     // Helper functions
-    void calculateMSTUsingPrim();
-    void calculateMSTUsingBoruvka();
-    std::vector<std::tuple<int, int, int, int>> convertGraphToEdges();
+    void calculateMSTUsingPrim(const CancelToken& token = CancelToken());
+    void calculateMSTUsingBoruvka(const CancelToken& token = CancelToken());
+    std::vector<std::tuple<int, int, int, int>> convertGraphToEdges(const CancelToken& token = CancelToken());
 };
 
 #endif // MST_HPP
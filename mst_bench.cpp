@@ -0,0 +1,135 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <latch>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include "affinity.hpp"
+#include "generator.hpp"
+#include "forest.hpp"
+#include "prim.hpp"
+#include "boruvka.hpp"
+
+/**
+ * MST benchmark on synthetic graphs.
+ * Usage: ./mst_bench [--repeat R] [--affinity] "<spec>" ...
+ * Every spec is a generator spec (see generator.hpp), e.g.
+ *   ./mst_bench "random n=2000 m=20000 seed=1" "grid rows=60 cols=60" "powerlaw n=2000 deg=8"
+ * For each graph the generation time and the throughput (edges per second) of prim, boruvka
+ * and the parallel spanning forest are reported.
+ * --affinity also runs prim on one thread per available core at once, first with floating threads,
+ * then with every thread pinned to its core and owning a node-local copy of the edges, and reports
+ * the aggregate throughput of both.
+ */
+
+using Clock = std::chrono::steady_clock;
+
+// Best wall time of repeat runs of fn, in seconds
+template <typename F>
+static double bestOf(int repeat, F fn)
+{
+    double best = 1e300;
+    for (int i = 0; i < repeat; ++i) {
+        auto start = Clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+// Aggregate prim throughput (edges per second) of one thread per available core running at once.
+// Every thread copies the edges itself after placement, so with pinning the copy is first touched
+// on the node of the core that processes it.
+static double concurrentThroughput(const std::vector<std::tuple<int, int, int, int>>& edges, int n,
+                                   int repeat, bool pinned)
+{
+    CpuSet cpus = availableCpus();
+    size_t threads = std::max<size_t>(1, cpus.size());
+    std::latch ready(threads), go(1);
+    std::vector<std::thread> runners;
+    for (size_t t = 0; t < threads; ++t) {
+        runners.emplace_back([&, t]() {
+            if (pinned && !cpus.empty()) placeCurrentThread({cpus[t]});
+            std::vector<std::tuple<int, int, int, int>> local = edges;
+            ready.count_down();
+            go.wait();
+            for (int i = 0; i < repeat; ++i) prim(local, n);
+        });
+    }
+    ready.wait();
+    auto start = Clock::now();
+    go.count_down();
+    for (auto& runner : runners) runner.join();
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    return static_cast<double>(threads) * repeat * edges.size() / elapsed;
+}
+
+int main(int argc, char* argv[])
+{
+    int repeat = 3;
+    bool affinity = false;
+    std::vector<std::string> specs;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--repeat" && i + 1 < argc) {
+            repeat = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--affinity") {
+            affinity = true;
+        } else {
+            specs.push_back(arg);
+        }
+    }
+    if (affinity) {
+        std::cout << "prim on " << std::max<size_t>(1, availableCpus().size()) << " concurrent thread(s), cores "
+                  << describeCpuSet(availableCpus()) << "\n";
+    }
+    if (specs.empty()) {
+        specs = {"random n=2000 m=20000 seed=1", "grid rows=50 cols=50 seed=2", "geometric n=2000 r=0.05 seed=3",
+                 "powerlaw n=2000 deg=8 seed=4", "complete n=600 seed=5"};
+    }
+
+    std::cout << std::left << std::setw(40) << "graph" << std::right << std::setw(10) << "edges"
+              << std::setw(12) << "gen ms" << std::setw(14) << "prim e/s" << std::setw(14) << "boruvka e/s"
+              << std::setw(14) << "forest e/s";
+    if (affinity) {
+        std::cout << std::setw(16) << "floating e/s" << std::setw(16) << "pinned e/s";
+    }
+    std::cout << "\n";
+
+    for (const std::string& text : specs) {
+        GeneratorSpec spec;
+        try {
+            spec = parseGeneratorSpec(text);
+        } catch (const std::exception& e) {
+            std::cerr << text << ": " << e.what() << "\n";
+            return 1;
+        }
+
+        std::vector<std::tuple<int, int, int>> generated;
+        double genTime = bestOf(repeat, [&]() { generated = generateEdges(spec); });
+
+        std::vector<std::tuple<int, int, int, int>> edges;
+        for (const auto& [u, v, w] : generated) {
+            edges.emplace_back(u, v, w, static_cast<int>(edges.size()));
+        }
+        int n = spec.vertices;
+        double m = static_cast<double>(edges.size());
+
+        double primTime = bestOf(repeat, [&]() { prim(edges, n); });
+        double boruvkaTime = bestOf(repeat, [&]() { boruvka(edges, n); });
+        double forestTime = bestOf(repeat, [&]() { spanningForest(edges, n, "prim"); });
+
+        std::cout << std::left << std::setw(40) << text << std::right << std::setw(10) << edges.size()
+                  << std::setw(12) << std::fixed << std::setprecision(2) << genTime * 1000
+                  << std::setw(14) << std::setprecision(0) << m / primTime
+                  << std::setw(14) << m / boruvkaTime << std::setw(14) << m / forestTime;
+        if (affinity) {
+            std::cout << std::setw(16) << concurrentThroughput(edges, n, repeat, false)
+                      << std::setw(16) << concurrentThroughput(edges, n, repeat, true);
+        }
+        std::cout << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "external_mst.hpp"
+
+/**
+ * Semi-external MST of an edge file that may be larger than memory.
+ * Usage: ./mst_external [--memory MB] [--tmp DIR] [--binary] [--vertices N] <edges> [<tree>]
+ * The edge file holds "u v w" triples (or packed int32 records with --binary). The minimum
+ * spanning forest is written to <tree> as "u v w" lines; progress and I/O volume go to stderr.
+ */
+
+using Clock = std::chrono::steady_clock;
+
+static double megabytes(uint64_t bytes)
+{
+    return static_cast<double>(bytes) / (1 << 20);
+}
+
+int main(int argc, char* argv[])
+{
+    ExternalMstOptions options;
+    std::string edgeFile, treeFile;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--memory" && i + 1 < argc) {
+                options.memoryBudget = static_cast<size_t>(std::stod(argv[++i]) * (1 << 20));
+            } else if (arg == "--tmp" && i + 1 < argc) {
+                options.tempDir = argv[++i];
+            } else if (arg == "--binary") {
+                options.binaryInput = true;
+            } else if (arg == "--vertices" && i + 1 < argc) {
+                options.vertices = std::stoi(argv[++i]);
+            } else if (edgeFile.empty() && arg[0] != '-') {
+                edgeFile = arg;
+            } else if (treeFile.empty() && arg[0] != '-') {
+                treeFile = arg;
+            } else {
+                throw std::invalid_argument("Unexpected argument '" + arg + "'");
+            }
+        }
+        if (edgeFile.empty()) throw std::invalid_argument("Missing edge file");
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\nUsage: " << argv[0]
+                  << " [--memory MB] [--tmp DIR] [--binary] [--vertices N] <edges> [<tree>]\n";
+        return 1;
+    }
+
+    auto start = Clock::now();
+    auto seconds = [&start]() { return std::chrono::duration<double>(Clock::now() - start).count(); };
+    std::cerr << std::fixed << std::setprecision(1);
+    options.progress = [&seconds](const ExternalMstProgress& progress) {
+        std::cerr << "[" << seconds() << "s] " << progress.phase << ": " << progress.edges << " edges, read "
+                  << megabytes(progress.bytesRead) << " MiB, written " << megabytes(progress.bytesWritten) << " MiB\n";
+    };
+
+    ExternalMstStats stats;
+    try {
+        stats = externalMst(edgeFile, treeFile, options);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "edges:          " << stats.edges << "\n"
+              << "vertices:       " << stats.vertices << "\n"
+              << "sorted runs:    " << stats.runs << " (" << stats.mergePasses << " intermediate merge passes)\n"
+              << "tree edges:     " << stats.treeEdges << " in " << stats.components << " component(s)\n"
+              << "total weight:   " << stats.totalWeight << "\n"
+              << std::fixed << std::setprecision(1)
+              << "read:           " << megabytes(stats.bytesRead) << " MiB\n"
+              << "written:        " << megabytes(stats.bytesWritten) << " MiB\n"
+              << "time:           " << seconds() << " s\n";
+    return 0;
+}
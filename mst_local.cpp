@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "shm_ring.hpp"
+
+/**
+ * Client for a server on the same host: loads an edge file into the server through the
+ * Unix-domain socket and a shared-memory edge ring, then runs commands on the graph.
+ * Usage: ./mst_local [--socket PATH] [--ring EDGES] [--vertices N] <edges> [command ...]
+ * The edge file holds "u v w" triples. Each further argument is sent as one command line
+ * (e.g. "mst prim" analyze); the server's replies go to stdout.
+ */
+
+#define DEFAULT_SOCKET "/tmp/mst_lf.sock"
+
+static int connectUnix(const std::string& path)
+{
+    struct sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Unix socket path too long: " + path);
+    }
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        std::string error = "Connecting to " + path + " failed: " + strerror(errno);
+        if (fd >= 0) close(fd);
+        throw std::runtime_error(error);
+    }
+    return fd;
+}
+
+// Writes data[sent..] to the socket
+static void sendFrom(int fd, const std::string& data, size_t sent)
+{
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("Send failed: ") + strerror(errno));
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
+
+// Sends line with descriptor attached (SCM_RIGHTS), so the server receives a copy of it with
+// the line's first bytes
+static void sendLineWithDescriptor(int fd, const std::string& line, int descriptor)
+{
+    std::string data = line + "\n";
+    iovec part{data.data(), data.size()};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr message{};
+    message.msg_iov = &part;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(header), &descriptor, sizeof(int));
+
+    ssize_t n;
+    while ((n = sendmsg(fd, &message, MSG_NOSIGNAL)) < 0 && errno == EINTR) {
+    }
+    if (n < 0) {
+        throw std::runtime_error(std::string("Sending the ring failed: ") + strerror(errno));
+    }
+    // The descriptor went with the first bytes; a short write only leaves plain bytes to send
+    sendFrom(fd, data, static_cast<size_t>(n));
+}
+
+static void sendLine(int fd, const std::string& line)
+{
+    sendFrom(fd, line + "\n", 0);
+}
+
+int main(int argc, char* argv[])
+{
+    std::string socketPath = DEFAULT_SOCKET, edgeFile;
+    uint32_t ringEdges = SHM_RING_EDGES;
+    int vertices = 0;
+    std::vector<std::string> commands;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--socket" && i + 1 < argc) {
+                socketPath = argv[++i];
+            } else if (arg == "--ring" && i + 1 < argc) {
+                ringEdges = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (arg == "--vertices" && i + 1 < argc) {
+                vertices = std::stoi(argv[++i]);
+            } else if (edgeFile.empty() && arg[0] != '-') {
+                edgeFile = arg;
+            } else if (!edgeFile.empty()) {
+                commands.push_back(arg);
+            } else {
+                throw std::invalid_argument("Unexpected argument '" + arg + "'");
+            }
+        }
+        if (edgeFile.empty()) throw std::invalid_argument("Missing edge file");
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\nUsage: " << argv[0]
+                  << " [--socket PATH] [--ring EDGES] [--vertices N] <edges> [command ...]\n";
+        return 1;
+    }
+
+    std::vector<ShmEdge> edges;
+    std::ifstream in(edgeFile);
+    if (!in) {
+        std::cerr << "Cannot open " << edgeFile << "\n";
+        return 1;
+    }
+    ShmEdge edge;
+    int largest = -1;
+    while (in >> edge.u >> edge.v >> edge.w) {
+        edges.push_back(edge);
+        largest = std::max({largest, edge.u, edge.v});
+    }
+    if (vertices == 0) vertices = largest + 1;
+
+    bool failed = false;
+    try {
+        ShmEdgeWriter ring(vertices, ringEdges);
+        int fd = connectUnix(socketPath);
+
+        // Replies are copied to stdout while this thread feeds the ring and sends the commands
+        std::thread replies([fd]() {
+            char buffer[65536];
+            ssize_t n;
+            while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+                std::cout.write(buffer, n);
+                std::cout.flush();
+            }
+        });
+
+        try {
+            sendLineWithDescriptor(fd, "shm", ring.descriptor());
+            ring.write(edges.data(), edges.size());
+            ring.close();
+            for (const std::string& command : commands) {
+                sendLine(fd, command);
+            }
+            sendLine(fd, "exit");
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            shutdown(fd, SHUT_RDWR);
+            failed = true;
+        }
+        // The ring must outlive the server's use of it: wait until the server closed the connection
+        replies.join();
+        close(fd);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return failed ? 1 : 0;
+}
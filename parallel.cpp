@@ -0,0 +1,128 @@
+#include "parallel.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iostream>
+#include <memory>
+
+// Constructor: starts the worker threads
+ThreadPool::ThreadPool(size_t threads, const CpuSet& cpus) : width(threads), stopFlag(false)
+{
+    for (size_t i = 0; i < threads; ++i) {
+        CpuSet core;
+        if (!cpus.empty()) core.push_back(cpus[i % cpus.size()]);
+        workers.emplace_back([this, core]() { workerLoop(core); });
+    }
+}
+
+// Constructor: no threads of its own, post hands the jobs to poster
+ThreadPool::ThreadPool(Poster poster, size_t threads)
+    : width(threads), external(std::move(poster)), stopFlag(false)
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        stopFlag = true;
+    }
+    cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+void ThreadPool::workerLoop(const CpuSet& cpus)
+{
+    TRACE_THREAD("pool");
+    try {
+        placeCurrentThread(cpus);
+    } catch (const std::exception& e) {
+        std::cerr << "Pool thread runs unpinned: " << e.what() << "\n";
+    }
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            cv.wait(lock, [this]() { return !jobs.empty() || stopFlag; });
+            if (stopFlag && jobs.empty()) return;
+            job = std::move(jobs.front());
+            jobs.pop();
+        }
+        job();
+    }
+}
+
+void ThreadPool::post(std::function<void()> job)
+{
+    if (external) {
+        external(std::move(job));
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(queueMutex);
+        jobs.push(std::move(job));
+    }
+    cv.notify_one();
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, const std::function<void(size_t)>& fn, size_t grain)
+{
+    if (begin >= end) return;
+    grain = std::max<size_t>(grain, 1);
+    size_t chunks = (end - begin + grain - 1) / grain;
+
+    // Shared with the helper jobs, which may still be dequeued after this call returned
+    struct State {
+        std::atomic<size_t> nextChunk{0};
+        std::atomic<size_t> doneChunks{0};
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<State>();
+
+    // Claims and runs chunks until none are left. fn is only touched while a chunk is claimed,
+    // and the caller does not return before every claimed chunk is done, so the reference is safe.
+    // Helpers work for the caller's request, so their spans are tagged with it.
+    uint64_t request = trace::currentRequest();
+    auto drain = [state, &fn, begin, end, grain, chunks, request]() {
+        TRACE_REQUEST(request);
+        size_t chunk;
+        while ((chunk = state->nextChunk.fetch_add(1)) < chunks) {
+            size_t first = begin + chunk * grain;
+            size_t last = std::min(end, first + grain);
+            try {
+                for (size_t i = first; i < last; ++i) {
+                    fn(i);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->error) state->error = std::current_exception();
+            }
+            if (state->doneChunks.fetch_add(1) + 1 == chunks) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->done.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min(size(), chunks - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        post(drain);
+    }
+    drain();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&state, chunks]() { return state->doneChunks.load() == chunks; });
+    if (state->error) std::rethrow_exception(state->error);
+}
@@ -0,0 +1,60 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include "affinity.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * Class: ThreadPool
+ * Fixed pool of worker threads for data-parallel library code (components, generators, ...).
+ * parallelFor splits a range into chunks that the workers and the calling thread claim one at a
+ * time, so it may safely be called from inside a pool job: the caller never just sits and waits
+ * for chunks nobody has started.
+ * With a non-empty cpus, worker i is pinned to core cpus[i % cpus.size()] and allocates
+ * node-local memory, like the stage and worker threads whose jobs it helps.
+ * A pool built on a Poster owns no threads: its jobs go to threads that already exist (a
+ * server's workers), so the helpers do not compete with them for the same cores.
+ */
+class ThreadPool {
+public:
+    using Poster = std::function<void(std::function<void()>)>;
+
+    explicit ThreadPool(size_t threads, const CpuSet& cpus = {});
+    // Pool whose jobs are handed to poster, which runs them on up to threads threads
+    ThreadPool(Poster poster, size_t threads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Process-wide pool with one thread per core
+    static ThreadPool& shared();
+
+    size_t size() const { return width; }
+
+    // Queues a job for the workers
+    void post(std::function<void()> job);
+
+    // Runs fn(i) for every i in [begin, end) and returns once all calls finished. Indices are
+    // handed out in chunks of grain. The first exception thrown by fn is rethrown here.
+    void parallelFor(size_t begin, size_t end, const std::function<void(size_t)>& fn, size_t grain = 1);
+
+private:
+    size_t width;                           // Threads that run the jobs
+    Poster external;                        // Set when the jobs run on threads the pool does not own
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> jobs;
+    std::mutex queueMutex;
+    std::condition_variable cv;
+    bool stopFlag;
+
+    void workerLoop(const CpuSet& cpus);
+};
+
+#endif // PARALLEL_HPP
@@ -0,0 +1,103 @@
+#include "path_index.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#define QUERY_GRAIN 1024 // Pairs per parallelFor chunk
+
+// Constructor: roots every tree at its first vertex (iterative DFS) and fills the lifting tables
+PathIndex::PathIndex(const std::vector<std::tuple<int, int, int, int>>& treeEdges, int n)
+    : numVertices(n), levels(1), tree(n, -1), depth(n, 0), rootDistance(n, 0)
+{
+    while ((1 << levels) < n) ++levels;
+    ++levels;
+
+    std::vector<std::vector<std::pair<int, int>>> adj(n);
+    for (const auto& [u, v, w, id] : treeEdges) {
+        adj[u].emplace_back(v, w);
+        adj[v].emplace_back(u, w);
+    }
+
+    up.assign(levels, std::vector<int>(n));
+    upMax.assign(levels, std::vector<int>(n, 0));
+
+    int trees = 0;
+    std::vector<int> stack;
+    for (int root = 0; root < n; ++root) {
+        if (tree[root] != -1) continue;
+        tree[root] = trees;
+        up[0][root] = root;
+        stack.push_back(root);
+        while (!stack.empty()) {
+            int u = stack.back();
+            stack.pop_back();
+            for (const auto& [v, w] : adj[u]) {
+                if (tree[v] != -1) continue;
+                tree[v] = trees;
+                depth[v] = depth[u] + 1;
+                rootDistance[v] = rootDistance[u] + w;
+                up[0][v] = u;
+                upMax[0][v] = w;
+                stack.push_back(v);
+            }
+        }
+        ++trees;
+    }
+
+    for (int k = 1; k < levels; ++k) {
+        for (int v = 0; v < n; ++v) {
+            int mid = up[k - 1][v];
+            up[k][v] = up[k - 1][mid];
+            upMax[k][v] = std::max(upMax[k - 1][v], upMax[k - 1][mid]);
+        }
+    }
+}
+
+PairAnswer PathIndex::query(int u, int v) const
+{
+    if (u < 0 || u >= numVertices || v < 0 || v >= numVertices) {
+        throw std::out_of_range("Vertex index out of range");
+    }
+    if (tree[u] != tree[v]) {
+        return {-1, -1, 0};
+    }
+
+    long long distance = rootDistance[u] + rootDistance[v];
+    int hops = depth[u] + depth[v];
+    int heaviest = 0;
+
+    // Lift the deeper vertex to the depth of the other, then both to just below their LCA
+    if (depth[u] < depth[v]) std::swap(u, v);
+    for (int k = levels - 1; k >= 0; --k) {
+        if (depth[u] - (1 << k) >= depth[v]) {
+            heaviest = std::max(heaviest, upMax[k][u]);
+            u = up[k][u];
+        }
+    }
+    if (u != v) {
+        for (int k = levels - 1; k >= 0; --k) {
+            if (up[k][u] != up[k][v]) {
+                heaviest = std::max({heaviest, upMax[k][u], upMax[k][v]});
+                u = up[k][u];
+                v = up[k][v];
+            }
+        }
+        heaviest = std::max({heaviest, upMax[0][u], upMax[0][v]});
+        u = up[0][u];
+    }
+
+    distance -= 2 * rootDistance[u];
+    hops -= 2 * depth[u];
+    return {distance, hops, heaviest};
+}
+
+std::vector<PairAnswer> PathIndex::queryAll(const std::vector<std::pair<int, int>>& pairs, ThreadPool& pool,
+                                            const CancelToken& token) const
+{
+    std::vector<PairAnswer> answers(pairs.size());
+    pool.parallelFor(0, pairs.size(), [&](size_t i) {
+        if (i % QUERY_GRAIN == 0) token.check();
+        answers[i] = query(pairs[i].first, pairs[i].second);
+    }, QUERY_GRAIN);
+    return answers;
+}
@@ -0,0 +1,46 @@
+#ifndef PATH_INDEX_HPP
+#define PATH_INDEX_HPP
+
+#include "cancel.hpp"
+#include "parallel.hpp"
+
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Answer about the tree path between two vertices of an MST (or spanning forest)
+struct PairAnswer {
+    long long distance;  // Total weight of the path, -1 if the vertices are in different trees
+    int hops;            // Number of edges on the path, -1 if unreachable
+    int heaviestEdge;    // Heaviest edge on the path (the minimax edge of the graph), 0 if u == v
+};
+
+/**
+ * Class: PathIndex
+ * Binary-lifting index over a spanning forest. Built once in O(n log n), it answers a path
+ * query in O(log n) without touching the rest of the tree, so a batch of queries is split
+ * across threads with no shared state.
+ */
+class PathIndex {
+public:
+    PathIndex(const std::vector<std::tuple<int, int, int, int>>& treeEdges, int n);
+
+    PairAnswer query(int u, int v) const;
+
+    // Answers every pair, in parallel; answers are in the order of the pairs.
+    // The token is polled once per chunk of pairs.
+    std::vector<PairAnswer> queryAll(const std::vector<std::pair<int, int>>& pairs,
+                                     ThreadPool& pool = ThreadPool::shared(),
+                                     const CancelToken& token = CancelToken()) const;
+
+private:
+    int numVertices;
+    int levels;                              // Number of binary-lifting levels, ceil(log2 n) + 1
+    std::vector<int> tree;                   // Tree (component) id of every vertex
+    std::vector<int> depth;                  // Edges from the tree root
+    std::vector<long long> rootDistance;     // Weight of the path from the tree root
+    std::vector<std::vector<int>> up;        // up[k][v]: 2^k-th ancestor of v (the root maps to itself)
+    std::vector<std::vector<int>> upMax;     // upMax[k][v]: heaviest edge on the way to up[k][v]
+};
+
+#endif // PATH_INDEX_HPP
@@ -11,10 +11,21 @@
 #include <vector>          
 #include "graph.hpp"       
 #include "mst.hpp"          
+#include "reactor.hpp"
+#include "session.hpp"
+#include "graph_registry.hpp"
+#include "affinity.hpp"
+#include "trace.hpp"
+#include "parallel.hpp"
 #include <csignal>
 #include <functional>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <chrono>
 
 #define PORT 8074 // Defines the port number on which the server will listen for client connections
+#define UNIX_SOCKET "/tmp/mst_pipeline.sock" // Default Unix-domain socket for clients on the same host
 bool close_server=false;
 /**
  * Class: ActiveObject
@@ -36,11 +47,19 @@ public:
     /**
      * Constructor: Starts the worker thread.
      * The worker thread runs in an infinite loop, waiting for tasks to be posted in the queue.
+     * With a non-empty cpus the thread is pinned to those cores and allocates node-local memory.
+     * name labels the thread and its jobs in traces.
      */
-    ActiveObject()
+    explicit ActiveObject(const char* name, const CpuSet& cpus = {})
     {
-        worker = std::thread([this]()
+        worker = std::thread([this, name, cpus]()
                              {
+                TRACE_THREAD(name);
+                try {
+                    placeCurrentThread(cpus);
+                } catch (const std::exception &e) {
+                    std::cerr << "Stage runs unpinned: " << e.what() << std::endl;
+                }
                 try {
                     while (running) {
                         std::function<void()> task;
@@ -55,6 +74,7 @@ public:
                             tasks.pop();
                         }
                         std::cout << "Executing task..." << std::endl;
+                        TRACE_SPAN(name);
                         task();  // Execute the task
                     }
                 } catch (const std::exception &e) {
@@ -101,218 +121,245 @@ public:
     }
 };
 
-Graph build_graph(int newSocket)
-{
-    std::string response = "----------Graph creation----------\nEnter the number of vertices: ";
-    send(newSocket, response.c_str(), response.size(), 0);
+// Named graphs shared by all connections
+GraphRegistry registry;
 
-    char answer[1024] = {0};
-    read(newSocket, answer, 1024);
-    int numVertices = std::stoi(answer);
+// Default time limit of a command's computation, zero for none (--deadline-ms)
+std::chrono::milliseconds requestDeadline(0);
 
-    // Create a new graph with the given number of vertices
-    Graph graph = Graph(numVertices); 
-
-    response = "Enter the number of edges: ";
-    send(newSocket, response.c_str(), response.size(), 0);
-
-    answer[1024] = {0};
-    read(newSocket, answer, 1024);
-    int numEdges = std::stoi(answer);
+/**
+ * Struct: PipelineShard
+ * One acceptor: a listening socket, the reactor that accepts on it and runs its sessions, and
+ * its own three pipeline stages. Every session of the shard posts its work to the same three
+ * ActiveObjects, so the number of threads does not grow with the number of clients, and shards
+ * never contend on each other's queue locks.
+ * stageCpus holds the cores of stage 1, 2 and 3; an empty set leaves that stage unpinned.
+ */
+struct PipelineShard
+{
+    int serverFd;
+    Reactor reactor;                  // Event loop that drives the shard's client sessions
+    ActiveObject stage1, stage2, stage3;
+    ThreadPool pool;                  // Data-parallel helpers of the stage jobs, private to this shard
+    SessionStages stages{Executor::of(stage1), Executor::of(stage2), Executor::of(stage3), pool};
+
+    PipelineShard(int serverFd, const std::vector<CpuSet> &stageCpus, size_t poolSize, const CpuSet &poolCpus)
+        : serverFd(serverFd), stage1("stage1.graph", stageCpus[0]), stage2("stage2.mst", stageCpus[1]),
+          stage3("stage3.analysis", stageCpus[2]), pool(poolSize, poolCpus) {}
+    ~PipelineShard() { close(serverFd); }
+};
 
-    // Add edges to the graph
-    for (int i = 0; i < numEdges; ++i)
-    {
-        response = "Enter an edge (from, to, weight): ";
-        send(newSocket, response.c_str(), response.size(), 0);
+/**
+ * Function: handleClientPipeline
+ * Client session coroutine. Socket I/O happens on the reactor thread, which the session
+ * gives up whenever it waits for the client; the compute of each command is handed to its stage:
+ * Stage 1: Graph creation
+ * Stage 2: MST creation
+ * Stage 3: Analyze data
+ */
+Task<void> handleClientPipeline(PipelineShard& shard, int newSocket)
+{
+    Connection conn(shard.reactor, newSocket);
+    ClientSession session(conn, registry, shard.stages, requestDeadline);
+    std::cout << "Pipeline started for client..." << std::endl;
 
-        int from, to, weight;
-        char edgeBuffer[1024] = {0};
-        read(newSocket, edgeBuffer, 1024);
-        std::istringstream edgeStream(edgeBuffer);
-        edgeStream >> from >> to >> weight;
-        graph.addEdge(from, to, weight);
-        std::string response = "Edge from " + std::to_string(from) + " -> " + std::to_string(to) +" with weight " + std::to_string(weight) + " added successfully!\n";
-        send(newSocket, response.c_str(), response.size(), 0);
+    try {
+        co_await session.run();
+    } catch (const std::exception &e) {
+        std::cerr << "Client pipeline failed: " << e.what() << std::endl;
     }
-    response = "New graph created!\n";
-    send(newSocket, response.c_str(), response.size(), 0);
-
-    return graph;
 }
 
-MST build_mst(Graph graph, int newSocket)
+// Accepts clients on serverFd (a listening socket of the shard) and starts a pipeline session for each of them
+Task<void> acceptLoop(PipelineShard& shard, int serverFd)
 {
-    std::string response = "----------MST creation----------\nEnter the algorithm of MST (prim or boruvka): ";
-    send(newSocket, response.c_str(), response.size(), 0);
-
-    char algoBuffer[1024] = {0};
-    read(newSocket, algoBuffer, 1024);
-    std::string algo(algoBuffer);
-
-    // if (algo != "prim" && algo != "boruvka") so make it prim
-    if (algo != "prim" && algo != "boruvka") {
-        algo = "prim";
+    while (!close_server) {
+        int newSocket = co_await shard.reactor.accept(serverFd);
+        std::cout << "Client connected! Starting the pipeline..." << std::endl;
+        spawn(handleClientPipeline(shard, newSocket));
     }
-
-    // Trim whitespace and newline characters
-    // algo.erase(algo.find_last_not_of(" \t\n\r") + 1);
-
-    MST mst = MST(graph.getGraph(), graph.getVertexCount(), algo); // Create the MST
-    response = "MST created using " + algo + " algorithm\n";
-    send(newSocket, response.c_str(), response.size(), 0);
-
-    return mst;
+    shard.reactor.stop();
 }
 
-void analyze_data(MST mst, int newSocket)
+/**
+ * Function: shardSlice
+ * The cores of shard out of shards: every shards-th core of each stage list, starting at the
+ * shard's index, so the shards split each stage's cores between them. A stage with fewer cores
+ * than shards gives each shard one of them, round-robin. An empty list stays empty (unpinned).
+ */
+static std::vector<CpuSet> shardSlice(const std::vector<CpuSet> &stageCpus, size_t shard, size_t shards)
 {
-    std::stringstream ss;
-
-    ss << "----------analyze_data----------\n";
-    ss << "Total Weight:  " << mst.getTotalWeight() << "\n";
-    ss << "Longest Distance (e.g. 0->1):  " << mst.getLongestDistance(0, 1) << "\n";
-    ss << "Shortest Distance (e.g. 0->1):  " << mst.getShortestDistance(0, 1) << "\n";
-    ss << "Average Edge Count:  " << mst.getAverageEdgeCount() << "\n";
-
-    send(newSocket, (ss.str()).c_str(), (ss.str()).size(), 0);
+    std::vector<CpuSet> slice(stageCpus.size());
+    for (size_t stage = 0; stage < stageCpus.size(); ++stage)
+    {
+        const CpuSet &cpus = stageCpus[stage];
+        if (cpus.empty())
+        {
+            continue;
+        }
+        if (cpus.size() < shards)
+        {
+            slice[stage].push_back(cpus[shard % cpus.size()]);
+            continue;
+        }
+        for (size_t i = shard; i < cpus.size(); i += shards)
+        {
+            slice[stage].push_back(cpus[i]);
+        }
+    }
+    return slice;
 }
 
-void handleClientPipeline(int newSocket)
+// Whole-string integer value of a command-line option; throws invalid_argument naming the option
+static int parseNumber(const std::string &option, const std::string &text)
 {
-    // Stage 1: Graph creation
-    // Stage 2: MST creation
-    // Stage 3: Analyze data
-    ActiveObject stage1, stage2, stage3;  // ActiveObject instances to handle stages of the pipeline
-
-    std::cout << "Pipeline started for client..." << std::endl;
-
-    // Condition variable for synchronization
-    std::mutex mutex;
-    std::condition_variable cv_2;
-    bool stage1Done = false;
-    bool stage2Done = false;
-    bool stage3Done = false;
-
-    // Stage 1: Build graph
-    stage1.post([&stage2, &stage3, &cv_2, &mutex, &stage1Done, &stage2Done, &stage3Done, newSocket]() {
-        Graph graph = build_graph(newSocket);
+    size_t used = 0;
+    int value = 0;
+    try
+    {
+        value = std::stoi(text, &used);
+    }
+    catch (const std::exception &)
+    {
+        used = 0;
+    }
+    if (used == 0 || used != text.size())
+    {
+        throw std::invalid_argument(option + " needs a number, got '" + text + "'");
+    }
+    return value;
+}
 
-        // Notify Stage 1
+int main(int argc, char *argv[])
+{
+    // --acceptors N: N acceptor threads, each with its own SO_REUSEPORT socket on PORT
+    // --deadline-ms MS: default time limit of every command's computation (0, the default, for none)
+    // --stage-cpus A:B:C: cores of stage 1, 2 and 3, each a list such as 0-1,4 (default: unpinned)
+    // --unix PATH: also accept local clients on this Unix-domain socket (default UNIX_SOCKET)
+    // --no-unix: TCP only
+    int acceptors = 1;
+    std::string unixPath = UNIX_SOCKET;
+    std::vector<CpuSet> stageCpus(3);
+    const char *usage = " [--acceptors N] [--deadline-ms MS] [--stage-cpus A:B:C] [--unix PATH | --no-unix]";
+    try
+    {
+        for (int i = 1; i < argc; ++i)
         {
-            std::lock_guard<std::mutex> lock(mutex);
-            stage1Done = true;
-        }
-        cv_2.notify_one();
-
-        // Pass the result to the next stage
-        stage2.post([&stage3, &cv_2, &mutex, &stage2Done, &stage3Done, graph, newSocket]() {
-            MST mst = build_mst(graph, newSocket);
-
-            // Notify Stage 2
+            std::string arg = argv[i];
+            if (arg == "--acceptors" && i + 1 < argc)
             {
-                std::lock_guard<std::mutex> lock(mutex);
-                stage2Done = true;
+                acceptors = std::max(1, parseNumber(arg, argv[++i]));
             }
-            cv_2.notify_one();
-
-            std::shared_ptr<MST> mstPtr = std::make_shared<MST>(mst);
-
-            // Pass the result to the final stage
-            stage3.post([&cv_2, &mutex, &stage3Done, mstPtr, newSocket]() {
-                std::cout << "Analyzing data 2..." << std::endl;
-                analyze_data(*mstPtr, newSocket);
-
-                // Notify Stage 3
+            else if (arg == "--deadline-ms" && i + 1 < argc)
+            {
+                requestDeadline = std::chrono::milliseconds(std::max(0, parseNumber(arg, argv[++i])));
+            }
+            else if (arg == "--stage-cpus" && i + 1 < argc)
+            {
+                stageCpus = parseCpuSets(argv[++i]);
+                if (stageCpus.size() != 3)
                 {
-                    std::lock_guard<std::mutex> lock(mutex);
-                    stage3Done = true;
+                    throw std::invalid_argument("--stage-cpus needs three core lists separated by ':'");
                 }
-                cv_2.notify_one();
-            });
-        });
-    });
-
-    // Wait for Stage 1 to finish
-    {
-        std::unique_lock<std::mutex> lock(mutex);
-        cv_2.wait(lock, [&stage1Done]() { return stage1Done; });
+                for (const CpuSet &cpus : stageCpus)
+                {
+                    checkCpuSet(cpus);
+                }
+            }
+            else if (arg == "--unix" && i + 1 < argc)
+            {
+                unixPath = argv[++i];
+            }
+            else if (arg == "--no-unix")
+            {
+                unixPath.clear();
+            }
+            else
+            {
+                std::cerr << "Usage: " << argv[0] << usage << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        }
     }
-
-    // Wait for Stage 2 to finish
+    catch (const std::exception &e)
     {
-        std::unique_lock<std::mutex> lock(mutex);
-        cv_2.wait(lock, [&stage2Done]() { return stage2Done; });
+        std::cerr << e.what() << std::endl;
+        std::cerr << "Usage: " << argv[0] << usage << std::endl;
+        exit(EXIT_FAILURE);
     }
 
-    // Wait for Stage 3 to finish
+    // Each shard fans its data-parallel work out over its own share of the cores: cores/acceptors
+    // floating threads, or with pinned stages one thread on each core of the shard's stage slice
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::unique_ptr<PipelineShard>> shards;
+    int unixFd = -1;
+    try
     {
-        std::unique_lock<std::mutex> lock(mutex);
-        cv_2.wait(lock, [&stage3Done]() { return stage3Done; });
+        for (int i = 0; i < acceptors; ++i)
+        {
+            std::vector<CpuSet> slice = shardSlice(stageCpus, i, acceptors);
+            CpuSet poolCpus;
+            for (const CpuSet &cpus : slice)
+            {
+                poolCpus.insert(poolCpus.end(), cpus.begin(), cpus.end());
+            }
+            std::sort(poolCpus.begin(), poolCpus.end());
+            poolCpus.erase(std::unique(poolCpus.begin(), poolCpus.end()), poolCpus.end());
+            size_t poolSize = poolCpus.empty() ? std::max<size_t>(1, cores / acceptors) : poolCpus.size();
+            shards.push_back(std::make_unique<PipelineShard>(listenOn(PORT, acceptors > 1), slice, poolSize, poolCpus));
+            if (!poolCpus.empty())
+            {
+                std::cout << "Shard " << i << " stages on cores " << describeCpuSet(slice[0]) << " | "
+                          << describeCpuSet(slice[1]) << " | " << describeCpuSet(slice[2]) << std::endl;
+            }
+        }
+        if (!unixPath.empty())
+        {
+            unixFd = listenUnix(unixPath);
+        }
     }
-
-    std::this_thread::sleep_for(std::chrono::seconds(4)); 
-    close(newSocket);
-}
-
-int main()
-{
-    
-    int serverFd, newSocket;
-    struct sockaddr_in address;
-    int addrlen = sizeof(address);
-    int opt = 1;
-
-    // Create socket
-    if ((serverFd = socket(AF_INET, SOCK_STREAM, 0)) == 0)
+    catch (const std::exception &e)
     {
-        std::cerr << "Socket creation failed" << std::endl;
+        std::cerr << e.what() << std::endl;
         exit(EXIT_FAILURE);
     }
 
-    // Allow port reuse
-    if (setsockopt(serverFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)))
+    std::cout << "Server is running with " << acceptors << " acceptor(s). Waiting for clients..." << std::endl;
+    if (unixFd >= 0)
     {
-        std::cerr << "setsockopt failed" << std::endl;
-        close(serverFd);
-        exit(EXIT_FAILURE);
+        std::cout << "Local clients on " << unixPath << std::endl;
     }
 
-    address.sin_family = AF_INET;
-    address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(PORT);
-
-    // Bind socket
-    if (bind(serverFd, (struct sockaddr *)&address, sizeof(address)) < 0)
+    // Accept clients and handle them on the reactors. The accept loops are started before the
+    // reactors run, since registering the listening socket must not race with the loop
+    for (auto &shard : shards)
     {
-        std::cerr << "Bind failed: " << strerror(errno) << std::endl;
-        close(serverFd);
-        exit(EXIT_FAILURE);
+        spawn(acceptLoop(*shard, shard->serverFd));
     }
-
-    // Start listening
-    if (listen(serverFd, 3) < 0)
+    // Local clients are few and light on the reactor: the first shard serves them as well
+    if (unixFd >= 0)
     {
-        std::cerr << "Listen failed: " << strerror(errno) << std::endl;
-        close(serverFd);
-        exit(EXIT_FAILURE);
+        spawn(acceptLoop(*shards[0], unixFd));
     }
-
-
-    std::cout << "Server is running. Waiting for clients..." << std::endl;
-
-    // Accept clients and handle them
-    while (true) {
-        if ((newSocket = accept(serverFd, (struct sockaddr *)&address, (socklen_t *)&addrlen)) < 0) {
-            std::cerr << "Accept failed: " << strerror(errno) << std::endl;
-        }
-
-        std::cout << "Client connected! Starting the pipeline..." << std::endl;
-        handleClientPipeline(newSocket);
-        // std::thread clientThread(handleClientPipeline, newSocket);
-        // clientThread.detach();
+    std::vector<std::thread> acceptorThreads;
+    for (size_t i = 1; i < shards.size(); ++i)
+    {
+        acceptorThreads.emplace_back([&shard = *shards[i]]() { shard.reactor.run(); });
     }
+    shards[0]->reactor.run();
 
-    close(serverFd);
+    for (auto &shard : shards)
+    {
+        shard->reactor.stop();
+    }
+    for (auto &thread : acceptorThreads)
+    {
+        thread.join();
+    }
+    if (unixFd >= 0)
+    {
+        close(unixFd);
+        unlink(unixPath.c_str());
+    }
     return 0;
-}
\ No newline at end of file
+}
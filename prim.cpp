@@ -1,4 +1,5 @@
 #include "prim.hpp"
+#include "trace.hpp"
 
 #include <chrono>
 #include <iostream>
@@ -10,6 +11,7 @@
 using namespace std;
 
 constexpr int INF = 0x3f3f3f3f;
+constexpr int CANCEL_CHECK_MASK = 1023; // Poll the cancel token every 1024 vertices
 
 struct Edge
 {
@@ -26,18 +28,29 @@ struct Edge
 	Edge(int _w, int _to, int _id) : w(_w), to(_to), id(_id) {}
 };
 
-vector<tuple<int, int, int, int>> _prim(const vector<vector<Edge>>& adj, int n)
+vector<tuple<int, int, int, int>> _prim(const vector<vector<Edge>>& adj, int n, const CancelToken& token)
 {
+	TRACE_SPAN("prim.grow");
 	vector<tuple<int, int, int, int>> spanning_tree;
 
 	vector<Edge> min_e(n);
-	min_e[0].w = 0;
 	set<Edge> q;
-	q.insert({0, 0, -1});
 
 	vector<bool> selected(n, false);
+	int nextRoot = 0;
 	for (int i = 0; i < n; ++i)
 	{
+		if ((i & CANCEL_CHECK_MASK) == 0) token.check();
+
+		// The current component is exhausted: grow the next tree from an unselected vertex,
+		// so a disconnected graph yields a spanning forest
+		if (q.empty())
+		{
+			while (selected[nextRoot]) ++nextRoot;
+			min_e[nextRoot].w = 0;
+			q.insert({0, nextRoot, -1});
+		}
+
 		int v = q.begin()->to;
 		selected[v] = true;
 		q.erase(q.begin());
@@ -61,18 +74,21 @@ vector<tuple<int, int, int, int>> _prim(const vector<vector<Edge>>& adj, int n)
 }
 
 vector<tuple<int, int, int, int>>
-	prim(const vector<tuple<int, int, int, int>>& edges, int n)
+	prim(const vector<tuple<int, int, int, int>>& edges, int n, const CancelToken& token)
 {
 	vector<vector<Edge>> adj(n);
-	for (const auto& e: edges)
 	{
-		int a, b, c, id;
-		tie(a, b, c, id) = e;
-		adj[a].push_back(Edge(c, b, id));
-		adj[b].push_back(Edge(c, a, id));
+		TRACE_SPAN("prim.adjacency");
+		for (const auto& e: edges)
+		{
+			int a, b, c, id;
+			tie(a, b, c, id) = e;
+			adj[a].push_back(Edge(c, b, id));
+			adj[b].push_back(Edge(c, a, id));
+		}
 	}
 
-	vector<tuple<int, int, int, int>> res = _prim(adj, n);
+	vector<tuple<int, int, int, int>> res = _prim(adj, n, token);
 
 	return res;
 }
\ No newline at end of file
@@ -3,13 +3,16 @@
 
 #include <utility>
 #include <vector>
+#include "cancel.hpp"
 
 using namespace std;
 
 // Source: https://cp-algorithms.com/graph/mst_prim.html
 // Implementation of Prim's algorithm for finding a MST.
-// Assumptions: vector<edges> corresponds to the edges of a connected graph 
+// For a disconnected graph the result is a minimum spanning forest (one tree per component).
 // Complexity: O(m log n)
-vector<tuple<int, int, int, int>> prim(const vector<tuple<int, int, int, int>>& edges,int n);
+// The token is polled every few vertices; a cancelled run throws Cancelled.
+vector<tuple<int, int, int, int>> prim(const vector<tuple<int, int, int, int>>& edges,int n,
+	const CancelToken& token = CancelToken());
 
 #endif
\ No newline at end of file
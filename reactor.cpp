@@ -0,0 +1,449 @@
+#include "reactor.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <netinet/in.h>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define MAX_EVENTS 64
+#define ACCEPT_BACKOFF_MS 100 // Pause before retrying accept when the process is out of fds or memory
+#define MAX_DESCRIPTORS_PER_READ 4 // Descriptors accepted with one read; the kernel closes the rest
+#define MAX_PENDING_DESCRIPTORS 4  // Received descriptors a connection keeps until they are taken
+
+// Constructor: creates the epoll set and the eventfd used for cross-thread wakeups
+Reactor::Reactor() : running(false)
+{
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        throw std::runtime_error(std::string("epoll_create1 failed: ") + strerror(errno));
+    }
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0) {
+        close(epollFd);
+        throw std::runtime_error(std::string("eventfd failed: ") + strerror(errno));
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+}
+
+Reactor::~Reactor()
+{
+    close(wakeFd);
+    close(epollFd);
+}
+
+// Function to record a waiting coroutine and (re)arm the fd in the epoll set
+void Reactor::wait(int fd, bool forWrite, std::coroutine_handle<> h)
+{
+    Interest& interest = interests[fd];
+    if (forWrite) {
+        interest.writer = h;
+    } else {
+        interest.reader = h;
+    }
+    arm(fd, interest);
+}
+
+// Function to arm the fd for the events its waiters need. EPOLLONESHOT keeps the kernel from
+// reporting the same readiness again before the woken coroutine had a chance to consume it.
+void Reactor::arm(int fd, Interest& interest)
+{
+    uint32_t events = 0;
+    if (interest.reader) events |= EPOLLIN | EPOLLRDHUP;
+    if (interest.writer) events |= EPOLLOUT;
+    if (interest.onHangup) events |= EPOLLHUP; // Always reported; named so the fd gets armed
+    if (interest.onHangup && interest.halfCloseIsHangup) events |= EPOLLRDHUP;
+    if (events == 0) return;
+
+    epoll_event ev{};
+    ev.events = events | EPOLLONESHOT;
+    ev.data.fd = fd;
+    int op = interest.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    if (epoll_ctl(epollFd, op, fd, &ev) < 0) {
+        throw std::runtime_error(std::string("epoll_ctl failed: ") + strerror(errno));
+    }
+    interest.registered = true;
+}
+
+void Reactor::forget(int fd)
+{
+    auto it = interests.find(fd);
+    if (it == interests.end()) return;
+    if (it->second.registered) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+    interests.erase(it);
+}
+
+void Reactor::watchHangup(int fd, std::function<void()> onHangup, bool inputPending)
+{
+    Interest& interest = interests[fd];
+    interest.onHangup = std::move(onHangup);
+    interest.halfCloseIsHangup = !inputPending;
+    arm(fd, interest);
+}
+
+void Reactor::unwatchHangup(int fd)
+{
+    auto it = interests.find(fd);
+    if (it != interests.end()) {
+        it->second.onHangup = nullptr;
+    }
+}
+
+// Function to wake the coroutines waiting on fd. Errors and hangups wake both sides so that
+// the next read()/send() reports them. The end of the peer's input (EPOLLRDHUP) wakes the reader;
+// for a hangup watch it is a hangup only once nothing is left to read. Otherwise the peer's last
+// commands are still queued and the watch stops asking for EPOLLRDHUP, which would fire again at
+// once, leaving resets and errors.
+void Reactor::dispatch(int fd, uint32_t events)
+{
+    auto it = interests.find(fd);
+    if (it == interests.end()) return;
+    Interest& interest = it->second;
+
+    std::coroutine_handle<> reader, writer;
+    if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) reader = std::exchange(interest.reader, {});
+    if (events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) writer = std::exchange(interest.writer, {});
+    bool peerGone = events & (EPOLLHUP | EPOLLERR);
+    if (!peerGone && (events & EPOLLRDHUP) && interest.onHangup && interest.halfCloseIsHangup) {
+        char next;
+        ssize_t n = recv(fd, &next, 1, MSG_PEEK | MSG_DONTWAIT);
+        if (n > 0) {
+            interest.halfCloseIsHangup = false;
+        } else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            peerGone = true;
+        }
+    }
+    std::function<void()> onHangup;
+    if (peerGone) onHangup = std::exchange(interest.onHangup, nullptr);
+    arm(fd, interest); // Oneshot disarmed the fd; keep watching for whoever is still waiting
+
+    if (onHangup) onHangup();
+    if (reader) reader.resume();
+    if (writer) writer.resume();
+}
+
+void Reactor::resumePosted()
+{
+    uint64_t counter;
+    while (read(wakeFd, &counter, sizeof(counter)) > 0) {
+    }
+
+    std::vector<std::coroutine_handle<>> ready;
+    {
+        std::lock_guard<std::mutex> lock(postedMutex);
+        ready.swap(posted);
+    }
+    for (auto h : ready) {
+        h.resume();
+    }
+}
+
+// Milliseconds until the earliest sleeping coroutine is due, -1 if none sleeps
+int Reactor::nextTimeout() const
+{
+    if (timers.empty()) return -1;
+    auto wait = std::chrono::ceil<std::chrono::milliseconds>(timers.begin()->first - Clock::now());
+    return static_cast<int>(std::clamp<long long>(wait.count(), 0, INT_MAX));
+}
+
+void Reactor::resumeTimers()
+{
+    Clock::time_point now = Clock::now();
+    while (!timers.empty() && timers.begin()->first <= now) {
+        std::coroutine_handle<> h = timers.begin()->second;
+        timers.erase(timers.begin());
+        h.resume();
+    }
+}
+
+void Reactor::run()
+{
+    TRACE_THREAD("reactor");
+    running = true;
+    epoll_event events[MAX_EVENTS];
+    while (running) {
+        int n = epoll_wait(epollFd, events, MAX_EVENTS, nextTimeout());
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("epoll_wait failed: ") + strerror(errno));
+        }
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.fd == wakeFd) {
+                resumePosted();
+            } else {
+                dispatch(events[i].data.fd, events[i].events);
+            }
+        }
+        resumeTimers();
+    }
+}
+
+void Reactor::stop()
+{
+    running = false;
+    uint64_t one = 1;
+    write(wakeFd, &one, sizeof(one));
+}
+
+void Reactor::post(std::coroutine_handle<> h)
+{
+    {
+        std::lock_guard<std::mutex> lock(postedMutex);
+        posted.push_back(h);
+    }
+    uint64_t one = 1;
+    write(wakeFd, &one, sizeof(one));
+}
+
+Task<int> Reactor::accept(int listenFd)
+{
+    while (true) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd >= 0) co_return fd;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            co_await readable(listenFd);
+        } else if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+            // Resources come back as other clients leave; the pending connections wait in the backlog
+            std::cerr << "Accept failed: " << strerror(errno) << ", retrying in " << ACCEPT_BACKOFF_MS << " ms\n";
+            co_await sleepFor(std::chrono::milliseconds(ACCEPT_BACKOFF_MS));
+        } else if (errno != EINTR && errno != ECONNABORTED) {
+            throw std::runtime_error(std::string("Accept failed: ") + strerror(errno));
+        }
+    }
+}
+
+// Constructor: switches the socket to non-blocking mode
+Connection::Connection(Reactor& reactor, int socketFd) : loop(reactor), fd(socketFd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+int Connection::takeDescriptor()
+{
+    if (descriptors.empty()) return -1;
+    int descriptor = descriptors.front();
+    descriptors.pop_front();
+    return descriptor;
+}
+
+Connection::~Connection()
+{
+    loop.forget(fd);
+    close(fd);
+    for (int descriptor : descriptors) {
+        close(descriptor);
+    }
+}
+
+// Reads into buffer like read(), keeping the descriptors a Unix-domain peer attached to the bytes.
+// On TCP sockets there is never any. The kernel closes the ones that do not fit into control.
+ssize_t Connection::receive(char* buffer, size_t size)
+{
+    iovec part{buffer, size};
+    alignas(cmsghdr) char control[CMSG_SPACE(MAX_DESCRIPTORS_PER_READ * sizeof(int))];
+    msghdr message{};
+    message.msg_iov = &part;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    ssize_t n = recvmsg(fd, &message, MSG_CMSG_CLOEXEC);
+    if (n < 0) return n;
+    for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) continue;
+        size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t i = 0; i < count; ++i) {
+            int descriptor;
+            memcpy(&descriptor, CMSG_DATA(header) + i * sizeof(int), sizeof(int));
+            // A peer that keeps sending descriptors nobody takes must not exhaust the server's table
+            if (descriptors.size() < MAX_PENDING_DESCRIPTORS) {
+                descriptors.push_back(descriptor);
+            } else {
+                close(descriptor);
+            }
+        }
+    }
+    return n;
+}
+
+Task<std::optional<std::string>> Connection::readLine()
+{
+    char chunk[4096];
+    while (true) {
+        size_t end = inbox.find('\n');
+        if (end != std::string::npos) {
+            std::string line = inbox.substr(0, end);
+            inbox.erase(0, end + 1);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            co_return line;
+        }
+
+        ssize_t n;
+        {
+            TRACE_SPAN("socket.read");
+            n = receive(chunk, sizeof(chunk));
+        }
+        if (n > 0) {
+            inbox.append(chunk, n);
+        } else if (n == 0) {
+            // Peer closed: hand out a final unterminated line if there is one
+            if (inbox.empty()) co_return std::nullopt;
+            co_return std::exchange(inbox, std::string());
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            co_await loop.readable(fd);
+        } else if (errno != EINTR) {
+            throw std::runtime_error(std::string("Read failed: ") + strerror(errno));
+        }
+    }
+}
+
+Task<void> Connection::send(std::string data)
+{
+    size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t n;
+        {
+            TRACE_SPAN("socket.send");
+            n = ::send(fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+        }
+        if (n >= 0) {
+            offset += n;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            co_await loop.writable(fd);
+        } else if (errno != EINTR) {
+            throw std::runtime_error(std::string("Send failed: ") + strerror(errno));
+        }
+    }
+}
+
+Task<void> Connection::sendv(iovec* parts, size_t count)
+{
+    // Skip empty parts up front so a partial write always lands inside a non-empty part
+    while (count > 0 && parts->iov_len == 0) {
+        ++parts;
+        --count;
+    }
+    while (count > 0) {
+        // sendmsg is writev with MSG_NOSIGNAL: a closed peer is an error, not a SIGPIPE
+        msghdr message{};
+        message.msg_iov = parts;
+        message.msg_iovlen = std::min<size_t>(count, IOV_MAX);
+        ssize_t n;
+        {
+            TRACE_SPAN("socket.sendmsg");
+            n = sendmsg(fd, &message, MSG_NOSIGNAL);
+        }
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                co_await loop.writable(fd);
+            } else if (errno != EINTR) {
+                throw std::runtime_error(std::string("Send failed: ") + strerror(errno));
+            }
+            continue;
+        }
+        // Drop the parts written completely and advance into the one written partially
+        size_t written = n;
+        while (count > 0 && written >= parts->iov_len) {
+            written -= parts->iov_len;
+            ++parts;
+            --count;
+        }
+        if (count > 0) {
+            parts->iov_base = static_cast<char*>(parts->iov_base) + written;
+            parts->iov_len -= written;
+        }
+    }
+}
+
+Task<std::string> Connection::prompt(std::string text)
+{
+    co_await send(std::move(text));
+    std::optional<std::string> answer = co_await readLine();
+    if (!answer) {
+        throw std::runtime_error("Client disconnected");
+    }
+    co_return *answer;
+}
+
+int listenOn(int port, bool reusePort)
+{
+    int serverFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (serverFd < 0) {
+        throw std::runtime_error(std::string("Socket creation failed: ") + strerror(errno));
+    }
+
+    // Allow port reuse
+    int opt = 1;
+    if (setsockopt(serverFd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) ||
+        (reusePort && setsockopt(serverFd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)))) {
+        std::string error = std::string("setsockopt failed: ") + strerror(errno);
+        close(serverFd);
+        throw std::runtime_error(error);
+    }
+
+    struct sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+
+    if (bind(serverFd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        std::string error = std::string("Bind failed: ") + strerror(errno);
+        close(serverFd);
+        throw std::runtime_error(error);
+    }
+
+    if (listen(serverFd, SOMAXCONN) < 0) {
+        std::string error = std::string("Listen failed: ") + strerror(errno);
+        close(serverFd);
+        throw std::runtime_error(error);
+    }
+    return serverFd;
+}
+
+int listenUnix(const std::string& path)
+{
+    struct sockaddr_un address{};
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Invalid Unix socket path: " + path);
+    }
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    // A stale socket from a server that did not shut down cleanly would make bind fail
+    struct stat info;
+    if (lstat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+        unlink(path.c_str());
+    }
+
+    int serverFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (serverFd < 0) {
+        throw std::runtime_error(std::string("Socket creation failed: ") + strerror(errno));
+    }
+    if (bind(serverFd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        std::string error = "Bind to " + path + " failed: " + strerror(errno);
+        close(serverFd);
+        throw std::runtime_error(error);
+    }
+    if (listen(serverFd, SOMAXCONN) < 0) {
+        std::string error = std::string("Listen failed: ") + strerror(errno);
+        close(serverFd);
+        unlink(path.c_str());
+        throw std::runtime_error(error);
+    }
+    return serverFd;
+}
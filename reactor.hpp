@@ -0,0 +1,216 @@
+#ifndef REACTOR_HPP
+#define REACTOR_HPP
+
+#include "coroutine.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sys/uio.h>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+/**
+ * Class: Reactor
+ * Single-threaded epoll event loop. Coroutines suspend on socket readiness
+ * (co_await reactor.readable(fd)) and are resumed from run() once the kernel reports
+ * the socket ready. Other threads hand coroutines back to the loop with post().
+ */
+class Reactor
+{
+private:
+    struct Interest {
+        std::coroutine_handle<> reader;  // Coroutine waiting for the fd to become readable
+        std::coroutine_handle<> writer;  // Coroutine waiting for the fd to become writable
+        std::function<void()> onHangup;  // Called once if the peer goes away while watched
+        bool halfCloseIsHangup = false;  // A half-close with no unread input also calls onHangup
+        bool registered = false;         // Whether the fd is currently in the epoll set
+    };
+
+    struct IoAwaiter {
+        Reactor& reactor;
+        int fd;
+        bool forWrite;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) { reactor.wait(fd, forWrite, h); }
+        void await_resume() const noexcept {}
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    struct SleepAwaiter {
+        Reactor& reactor;
+        Clock::time_point until;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) { reactor.timers.emplace(until, h); }
+        void await_resume() const noexcept {}
+    };
+
+    int epollFd;
+    int wakeFd;                                  // eventfd used to interrupt epoll_wait from other threads
+    std::atomic<bool> running;
+    std::unordered_map<int, Interest> interests; // Only touched from the reactor thread
+    std::mutex postedMutex;
+    std::vector<std::coroutine_handle<>> posted; // Coroutines handed over by other threads
+    std::multimap<Clock::time_point, std::coroutine_handle<>> timers; // Sleeping coroutines, reactor thread only
+
+    void wait(int fd, bool forWrite, std::coroutine_handle<> h);
+    void arm(int fd, Interest& interest);
+    void dispatch(int fd, uint32_t events);
+    void resumePosted();
+    int nextTimeout() const;
+    void resumeTimers();
+
+public:
+    Reactor();
+    ~Reactor();
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    // Runs the event loop on the calling thread until stop() is called
+    void run();
+    // Thread-safe: makes run() return after the current iteration
+    void stop();
+    // Thread-safe: resumes h on the reactor thread
+    void post(std::coroutine_handle<> h);
+
+    // Awaitables that suspend the calling coroutine until fd is ready
+    IoAwaiter readable(int fd) { return {*this, fd, false}; }
+    IoAwaiter writable(int fd) { return {*this, fd, true}; }
+    // Suspends the calling coroutine (on the reactor thread) for at least delay, without an fd
+    SleepAwaiter sleepFor(std::chrono::milliseconds delay) { return {*this, Clock::now() + delay}; }
+    // Drops every interest in fd; must be called before the fd is closed
+    void forget(int fd);
+    // Calls onHangup on the reactor thread, at most once, if the peer goes away while the watch is
+    // set (also when nobody is reading): on a reset or error, or when its input ends and nothing is
+    // left to read. A FIN looks the same whether the peer closed or only shut down its sending
+    // side, so pending input decides: with unread bytes in the socket, or inputPending (lines the
+    // caller already buffered), the peer is taken to be waiting for the replies to them.
+    void watchHangup(int fd, std::function<void()> onHangup, bool inputPending = false);
+    void unwatchHangup(int fd);
+
+    // Accepts the next connection on a non-blocking listening socket. Running out of fds or
+    // kernel memory is logged and retried after a short pause instead of failing the caller.
+    Task<int> accept(int listenFd);
+};
+
+/**
+ * Class: Connection
+ * A non-blocking client socket bound to a reactor. Owns the fd and closes it on destruction.
+ * Input is framed into lines, one line per answer to a prompt.
+ */
+class Connection
+{
+private:
+    Reactor& loop;
+    int fd;
+    std::string inbox;           // Bytes received but not yet consumed as a line
+    std::deque<int> descriptors; // Descriptors received with the input (SCM_RIGHTS), not yet taken
+
+    ssize_t receive(char* buffer, size_t size);
+
+public:
+    Connection(Reactor& reactor, int socketFd);
+    ~Connection();
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    int socket() const { return fd; }
+    // Whether bytes were received but not yet handed out by readLine
+    bool hasBufferedInput() const { return !inbox.empty(); }
+    // Oldest descriptor a Unix-domain peer attached to the input read so far (SCM_RIGHTS), or -1.
+    // The caller owns it; descriptors never taken are closed with the connection.
+    int takeDescriptor();
+    Reactor& reactor() { return loop; }
+
+    // Next line without its terminator, or nullopt once the peer has closed the connection
+    Task<std::optional<std::string>> readLine();
+    // Writes all of data, suspending while the socket buffer is full
+    Task<void> send(std::string data);
+    // Gathers all bytes of parts[0..count) into the socket with as few system calls as the socket
+    // buffer allows, suspending while it is full. parts is advanced past what was written, so the
+    // buffers must stay valid until the task completes.
+    Task<void> sendv(iovec* parts, size_t count);
+    // Sends text and returns the answer line; throws if the peer disconnects instead
+    Task<std::string> prompt(std::string text);
+};
+
+// Creates a non-blocking TCP socket listening on port on all interfaces; throws on failure.
+// With reusePort several sockets may listen on the same port (SO_REUSEPORT) and the kernel
+// spreads incoming connections across them.
+int listenOn(int port, bool reusePort);
+
+// Creates a non-blocking Unix-domain socket listening on path for clients on the same host;
+// throws on failure. A socket left at path by an earlier run is replaced, any other file is not.
+int listenUnix(const std::string& path);
+
+/**
+ * Class: OffloadAwaiter
+ * Runs fn on an executor (anything with post(std::function<void()>), e.g. an ActiveObject
+ * or a thread pool) and resumes the awaiting coroutine on the reactor with fn's result.
+ */
+template <typename Executor, typename F>
+class OffloadAwaiter
+{
+public:
+    using Result = std::invoke_result_t<F&>;
+
+    OffloadAwaiter(Reactor& reactor, Executor& executor, F fn)
+        : reactor(reactor), executor(executor), fn(std::move(fn)) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+        executor.post([this, h]() {
+            try {
+                if constexpr (std::is_void_v<Result>) {
+                    fn();
+                    result.emplace();
+                } else {
+                    result.emplace(fn());
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+            reactor.post(h);
+        });
+    }
+
+    Result await_resume()
+    {
+        if (error) std::rethrow_exception(error);
+        if constexpr (!std::is_void_v<Result>) return std::move(*result);
+    }
+
+private:
+    using Storage = std::conditional_t<std::is_void_v<Result>, std::monostate, Result>;
+
+    Reactor& reactor;
+    Executor& executor;
+    F fn;
+    std::optional<Storage> result;
+    std::exception_ptr error;
+};
+
+// co_await offload(reactor, pool, [&] { return expensive(); });
+// Capture locals of the awaiting coroutine by reference: they outlive the co_await, and GCC 12
+// destroys closures with non-trivial by-value captures created inside a co_await expression twice.
+template <typename Executor, typename F>
+OffloadAwaiter<Executor, F> offload(Reactor& reactor, Executor& executor, F fn)
+{
+    return OffloadAwaiter<Executor, F>(reactor, executor, std::move(fn));
+}
+
+#endif // REACTOR_HPP
@@ -0,0 +1,722 @@
+#include "session.hpp"
+#include "forest.hpp"
+#include "generator.hpp"
+#include "shm_ring.hpp"
+#include "trace.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <utility>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+static const char* MENU =
+    "----------Commands----------\n"
+    "new                   Build a private graph step by step, then its MST and analysis\n"
+    "create <name> <n>     Create a shared graph with n vertices and attach to it\n"
+    "attach <name>         Attach to an existing shared graph\n"
+    "generate <kind> [key=value ...] [name=<name>]\n"
+    "                      Generate a random, grid, geometric, powerlaw or complete graph on the server\n"
+    "                      (keys: n m rows cols r exp deg w=min..max seed); name= shares it\n"
+    "shm [name=<name>]     Build a graph from the edges a local client streams through a shared\n"
+    "                      memory ring (ShmEdgeWriter) and attach to it; name= shares it.\n"
+    "                      Unix-domain socket only, with the ring's sealed memfd attached\n"
+    "list                  List the shared graphs\n"
+    "drop <name>           Remove a shared graph from the list; attached connections keep it\n"
+    "addEdge <u> <v> <w>   Add an edge to the attached graph\n"
+    "removeEdge <u> <v>    Remove an edge from the attached graph\n"
+    "mst <prim|boruvka>    Compute the MST of the attached graph\n"
+    "forest <prim|boruvka> Compute a spanning forest of the attached graph, per connected component\n"
+    "analyze               Analyze the last computed MST\n"
+    "approx [err=0.05] [time=1000] [seed=1]\n"
+    "                      Estimate the average and longest distance by sampling, until the 95%\n"
+    "                      interval is within err of the average or time ms have passed\n"
+    "query <k> [u v ...]   Path distance, hops and heaviest edge in the MST for k vertex pairs;\n"
+    "                      the 2k vertex numbers may continue on the following lines\n"
+    "export <text|binary>  Stream the edges of the last MST: \"u v w\" lines, or int32 u v w records\n"
+    "deadline <ms>         Time limit of each following command's computation (0 for none)\n"
+    "exit                  Close the connection\n";
+
+#define RESULT_CHUNK 65536 // Bytes of query results gathered before each send
+#define EXPORT_BUFFER 65536 // Bytes per export buffer
+#define EXPORT_BUFFERS 8    // Export buffers gathered into one sendmsg
+#define TEXT_EDGE_MAX 36    // Longest "u v w\n" line: three int32 values and their separators
+#define APPROX_MIN_SOURCES 30 // Sources sampled before the confidence interval may stop the estimate
+#define APPROX_REPORT_MS 100  // Least time between two progress lines of approx
+#define MAX_VERTICES 10000    // Largest graph a client may make the server allocate (4n^2 bytes of matrix)
+
+// Reads the next integer argument of a command
+static int readInt(std::istringstream& args, const char* name)
+{
+    int value;
+    if (!(args >> value)) {
+        throw std::invalid_argument(std::string("Missing or invalid argument <") + name + ">");
+    }
+    return value;
+}
+
+// Rejects a vertex count before anything of size O(n^2) is allocated or generated
+static void checkVertexCount(long long vertices)
+{
+    if (vertices < 0 || vertices > MAX_VERTICES) {
+        throw std::invalid_argument("Number of vertices must be between 0 and " + std::to_string(MAX_VERTICES));
+    }
+}
+
+static std::string readWord(std::istringstream& args, const char* name)
+{
+    std::string value;
+    if (!(args >> value)) {
+        throw std::invalid_argument(std::string("Missing argument <") + name + ">");
+    }
+    return value;
+}
+
+static std::string describe(const std::string& name, const GraphSnapshot& snapshot)
+{
+    return (name.empty() ? std::string("private graph") : "graph '" + name + "'") + ": " +
+           std::to_string(snapshot.graph.getVertexCount()) + " vertices, " +
+           std::to_string(snapshot.graph.getEdgeCount()) + " edges, version " +
+           std::to_string(snapshot.version);
+}
+
+/**
+ * Class: HangupWatch
+ * Watches the client socket while a command is served and cancels the command's token as soon
+ * as the client hangs up, even while the session is not reading (waiting on a stage). A client
+ * that closes after its last command counts as gone; one that has sent further commands before
+ * shutting down its side (nc -N) is still waiting for their replies.
+ */
+class HangupWatch {
+public:
+    HangupWatch(Connection& conn, std::function<void()> onHangup) : conn(conn)
+    {
+        conn.reactor().watchHangup(conn.socket(), std::move(onHangup), conn.hasBufferedInput());
+    }
+    ~HangupWatch() { conn.reactor().unwatchHangup(conn.socket()); }
+    HangupWatch(const HangupWatch&) = delete;
+    HangupWatch& operator=(const HangupWatch&) = delete;
+
+private:
+    Connection& conn;
+};
+
+// Encodes edges from next on into buffer, as many as fit; returns the number of bytes used
+static size_t encodeEdges(const std::vector<std::tuple<int, int, int, int>>& edges, size_t& next,
+                          std::vector<char>& buffer, bool binary)
+{
+    char* out = buffer.data();
+    char* end = out + buffer.size();
+    for (; next < edges.size(); ++next) {
+        const auto& [u, v, w, id] = edges[next];
+        if (binary) {
+            if (end - out < static_cast<long>(3 * sizeof(int32_t))) break;
+            int32_t record[3] = {u, v, w};
+            memcpy(out, record, sizeof(record));
+            out += sizeof(record);
+        } else {
+            if (end - out < TEXT_EDGE_MAX) break;
+            out = std::to_chars(out, end, u).ptr;
+            *out++ = ' ';
+            out = std::to_chars(out, end, v).ptr;
+            *out++ = ' ';
+            out = std::to_chars(out, end, w).ptr;
+            *out++ = '\n';
+        }
+    }
+    return out - buffer.data();
+}
+
+// Runs fn on stage for the current command, under the command's request id for tracing.
+// Skipped if the command was cancelled before the stage got to it.
+template <typename F>
+auto ClientSession::compute(Executor& stage, const char* name, F&& fn)
+{
+    return offload(conn.reactor(), stage, [this, name, &fn]() {
+        TRACE_REQUEST(requestId);
+        TRACE_SPAN(name);
+        token.check();
+        return fn();
+    });
+}
+
+// Constructor
+ClientSession::ClientSession(Connection& conn, GraphRegistry& registry, SessionStages& stages,
+                             std::chrono::milliseconds deadline)
+    : conn(conn), registry(registry), stages(stages), deadline(deadline) {}
+
+void ClientSession::restartDeadline()
+{
+    // A hangup is final; only the time limit starts over
+    if (!hungUp) {
+        token = CancelToken::withTimeout(deadline);
+    }
+}
+
+void ClientSession::attach(const std::string& name, std::shared_ptr<SharedGraph> target)
+{
+    graphName = name;
+    graph = std::move(target);
+    mst.reset();
+}
+
+SharedGraph& ClientSession::requireGraph() const
+{
+    if (!graph) {
+        throw std::logic_error("No graph attached (use new, create or attach)");
+    }
+    return *graph;
+}
+
+MST& ClientSession::requireMst() const
+{
+    if (!mst) {
+        throw std::logic_error("No MST computed yet (use mst <prim|boruvka>)");
+    }
+    return *mst;
+}
+
+Task<void> ClientSession::build_graph()
+{
+    std::string answer = co_await conn.prompt("----------Graph creation----------\nEnter the number of vertices: ");
+    int numVertices = std::stoi(answer);
+    checkVertexCount(numVertices);
+
+    answer = co_await conn.prompt("Enter the number of edges: ");
+    int numEdges = std::stoi(answer);
+
+    // Read the edges on the reactor; the graph itself is built on the graph stage
+    std::vector<std::tuple<int, int, int>> edges;
+    for (int i = 0; i < numEdges; ++i)
+    {
+        int from, to, weight;
+        std::istringstream edgeStream(co_await conn.prompt("Enter an edge (from, to, weight): "));
+        edgeStream >> from >> to >> weight;
+        edges.emplace_back(from, to, weight);
+        co_await conn.send("Edge from " + std::to_string(from) + " -> " + std::to_string(to) +" with weight " + std::to_string(weight) + " added successfully!\n");
+    }
+
+    restartDeadline();
+    std::shared_ptr<SharedGraph> built = co_await compute(stages.graph, "graph.build", [numVertices, &edges]() {
+        // Create a new graph with the given number of vertices
+        Graph graph = Graph(numVertices);
+        for (const auto& [from, to, weight] : edges)
+        {
+            graph.addEdge(from, to, weight);
+        }
+        return std::make_shared<SharedGraph>(std::move(graph));
+    });
+    attach("", std::move(built));
+    co_await conn.send("New graph created!\n");
+}
+
+Task<void> ClientSession::build_mst(std::string algo)
+{
+    // if (algo != "prim" && algo != "boruvka") so make it prim
+    if (algo != "prim" && algo != "boruvka") {
+        algo = "prim";
+    }
+
+    // The MST is computed from the snapshot current at this point; later updates by other
+    // connections publish new snapshots and do not disturb it
+    std::shared_ptr<const GraphSnapshot> snapshot = requireGraph().snapshot();
+    mst = co_await compute(stages.mst, "mst.build", [this, &snapshot, &algo]() {
+        const Graph& graph = snapshot->graph;
+        return std::make_shared<MST>(graph, algo, token); // Create the MST
+    });
+    mstVersion = snapshot->version;
+
+    co_await conn.send("MST created using " + algo + " algorithm (graph version " + std::to_string(mstVersion) + ")\n");
+}
+
+Task<void> ClientSession::analyze_data()
+{
+    requireMst();
+    std::shared_ptr<MST> tree = mst;
+    // The distances are reported for the pair 0->1
+    if (tree->getVertexCount() < 2) {
+        throw std::invalid_argument("analyze needs a graph with at least 2 vertices");
+    }
+    std::string report = co_await compute(stages.analysis, "analysis.analyze", [this, &tree]() {
+        std::stringstream ss;
+
+        ss << "----------analyze_data----------\n";
+        ss << "Total Weight:  " << tree->getTotalWeight() << "\n";
+        ss << "Longest Distance (e.g. 0->1):  " << tree->getLongestDistance(0, 1, token) << "\n";
+        ss << "Shortest Distance (e.g. 0->1):  " << tree->getShortestDistance(0, 1, token) << "\n";
+        ss << "Average Edge Count:  " << tree->getAverageEdgeCount(token) << "\n";
+
+        return std::move(ss).str();
+    });
+
+    co_await conn.send(std::move(report));
+}
+
+// Value of a key=value option of approx
+template <typename T>
+static T parseOption(const std::string& key, const std::string& value)
+{
+    std::istringstream in(value);
+    T result;
+    if (!(in >> result) || !in.eof()) {
+        throw std::invalid_argument("Invalid value for " + key + ": " + value);
+    }
+    return result;
+}
+
+// Runs each job on a new thread of its own, for jobs that mostly wait on the client
+static Executor ownThread([](Executor::Job job) { std::thread(std::move(job)).detach(); });
+
+// One progress line of the approximate analysis
+static std::string describeEstimate(const DistanceEstimate& estimate)
+{
+    char interval[64];
+    if (std::isinf(estimate.halfWidth)) {
+        snprintf(interval, sizeof(interval), "%.2f", estimate.average);
+    } else {
+        snprintf(interval, sizeof(interval), "%.2f +- %.2f (%.1f%%)", estimate.average, estimate.halfWidth,
+                 100 * estimate.relativeError());
+    }
+    std::string text = "Sources " + std::to_string(estimate.sources) + "/" + std::to_string(estimate.vertices) +
+                       ": average distance " + interval + ", longest distance ";
+    if (estimate.exact) {
+        text += std::to_string(estimate.longestAtLeast);
+    } else {
+        text += ">= " + std::to_string(estimate.longestAtLeast);
+        if (estimate.longestAtMost >= 0) text += ", <= " + std::to_string(estimate.longestAtMost);
+    }
+    return text + "\n";
+}
+
+Task<void> ClientSession::analyzeApprox(std::istringstream& args)
+{
+    double targetError = 0.05;
+    long long budgetMs = 1000;
+    uint64_t seed = 1;
+    std::string word;
+    while (args >> word) {
+        size_t eq = word.find('=');
+        std::string key = word.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : word.substr(eq + 1);
+        if (key == "err") targetError = parseOption<double>(key, value);
+        else if (key == "time") budgetMs = parseOption<long long>(key, value);
+        else if (key == "seed") seed = parseOption<uint64_t>(key, value);
+        else throw std::invalid_argument("Unknown option '" + word + "' (err=, time= or seed=)");
+    }
+    if (targetError <= 0 || budgetMs <= 0) {
+        throw std::invalid_argument("err and time must be positive");
+    }
+    requireMst();
+    std::shared_ptr<MST> tree = mst;
+    // Without an edge no pair is connected and there is no average to estimate
+    if (tree->getEdges().empty()) {
+        throw std::invalid_argument("No reachable pairs: the graph has no edges");
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    std::shared_ptr<DistanceSampler> sampler = co_await compute(stages.analysis, "analysis.sampler", [this, &tree, seed]() {
+        return std::make_shared<DistanceSampler>(tree->distanceSampler(seed, stages.pool));
+    });
+    co_await conn.send("----------approximate analysis----------\n");
+
+    // One batch per stage job, streaming the estimate as it tightens (at most one line per APPROX_REPORT_MS)
+    std::string reason;
+    auto reported = start;
+    while (reason.empty()) {
+        DistanceEstimate estimate = co_await compute(stages.analysis, "analysis.sample", [this, &sampler]() {
+            return sampler->step(0, token);
+        });
+
+        auto now = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - start);
+        if (estimate.exact) {
+            reason = "exact, every vertex sampled";
+        } else if (estimate.sources >= APPROX_MIN_SOURCES && estimate.relativeError() <= targetError) {
+            reason = "target error reached";
+        } else if (elapsed.count() >= budgetMs) {
+            reason = "time budget used";
+        }
+        if (!reason.empty() || now - reported >= std::chrono::milliseconds(APPROX_REPORT_MS)) {
+            reported = now;
+            co_await conn.send(describeEstimate(estimate));
+        }
+    }
+    co_await conn.send("Stopped: " + reason + "\n");
+}
+
+Task<void> ClientSession::build_forest(std::string algo)
+{
+    if (algo != "prim" && algo != "boruvka") {
+        algo = "prim";
+    }
+
+    std::shared_ptr<const GraphSnapshot> snapshot = requireGraph().snapshot();
+    std::shared_ptr<MST> tree;
+    std::string report = co_await compute(stages.mst, "mst.forest", [this, &snapshot, &algo, &tree]() {
+        const Graph& graph = snapshot->graph;
+        tree = std::make_shared<MST>(graph);
+        SpanningForest forest = tree->spanningForest(algo, stages.pool, token);
+
+        long long totalWeight = 0;
+        for (const ComponentStats& component : forest.components) {
+            totalWeight += component.totalWeight;
+        }
+
+        std::stringstream ss;
+        ss << "----------spanning forest----------\n";
+        ss << "Spanning forest using " << algo << " algorithm (graph version " << snapshot->version << "): "
+           << forest.components.size() << " components, " << forest.edges.size() << " edges, total weight "
+           << totalWeight << "\n";
+        for (size_t c = 0; c < forest.components.size(); ++c) {
+            const ComponentStats& component = forest.components[c];
+            ss << "Component " << c << " (root " << component.root << "): " << component.vertices << " vertices, "
+               << component.edges << " edges, weight " << component.totalWeight << ", diameter "
+               << component.diameter << ", heaviest edge " << component.maxEdgeWeight << "\n";
+        }
+        return std::move(ss).str();
+    });
+    mst = std::move(tree);
+    mstVersion = snapshot->version;
+
+    co_await conn.send(std::move(report));
+}
+
+Task<void> ClientSession::queryPairs(std::istringstream& args)
+{
+    int count = readInt(args, "k");
+    if (count < 0) {
+        throw std::invalid_argument("Number of pairs must not be negative");
+    }
+    requireMst();
+    std::shared_ptr<MST> tree = mst;
+
+    // Vertex numbers follow on the command line and on as many further lines as needed
+    std::vector<int> vertices;
+    vertices.reserve(2 * static_cast<size_t>(count));
+    auto take = [&vertices, count](std::istringstream& in) {
+        int vertex;
+        while (vertices.size() < 2 * static_cast<size_t>(count) && in >> vertex) {
+            vertices.push_back(vertex);
+        }
+        if (!in && !in.eof()) {
+            throw std::invalid_argument("Invalid vertex number in pair list");
+        }
+    };
+    take(args);
+    while (vertices.size() < 2 * static_cast<size_t>(count)) {
+        std::optional<std::string> line = co_await conn.readLine();
+        if (!line) {
+            throw std::runtime_error("Client disconnected");
+        }
+        std::istringstream in(*line);
+        take(in);
+    }
+
+    std::vector<std::pair<int, int>> pairs(count);
+    for (int i = 0; i < count; ++i) {
+        pairs[i] = {vertices[2 * i], vertices[2 * i + 1]};
+    }
+
+    // One index for the whole batch, queries spread over the thread pool
+    restartDeadline();
+    std::vector<PairAnswer> answers = co_await compute(stages.analysis, "analysis.query", [this, &tree, &pairs]() {
+        return tree->queryPairs(pairs, stages.pool, token);
+    });
+
+    // Stream the answers back one "distance hops heaviest" line per pair, in chunks
+    std::string chunk = "----------pair queries----------\n" + std::to_string(count) +
+                        " pairs (distance hops heaviest-edge, -1 if unreachable):\n";
+    for (const PairAnswer& answer : answers) {
+        chunk += std::to_string(answer.distance) + ' ' + std::to_string(answer.hops) + ' ' +
+                 std::to_string(answer.heaviestEdge) + '\n';
+        if (chunk.size() >= RESULT_CHUNK) {
+            co_await conn.send(std::exchange(chunk, std::string()));
+        }
+    }
+    co_await conn.send(std::move(chunk));
+}
+
+Task<void> ClientSession::exportMst(std::istringstream& args)
+{
+    std::string format = readWord(args, "format");
+    if (format != "text" && format != "binary") {
+        throw std::invalid_argument("Export format must be text or binary");
+    }
+    requireMst();
+    std::shared_ptr<MST> tree = mst;
+    const std::vector<std::tuple<int, int, int, int>>& edges = tree->getEdges();
+    bool binary = format == "binary";
+
+    // The header says how much follows: edge lines, or 12-byte records in host byte order
+    std::string header = "----------MST export----------\n" + format + " " + std::to_string(edges.size()) +
+                         " edges (graph version " + std::to_string(mstVersion) + ")\n";
+
+    // A fixed set of buffers, refilled and gathered into one sendmsg per batch, so the export never
+    // holds more than EXPORT_BUFFERS * EXPORT_BUFFER bytes however large the tree is
+    std::vector<std::vector<char>> buffers(EXPORT_BUFFERS, std::vector<char>(EXPORT_BUFFER));
+    iovec parts[EXPORT_BUFFERS + 1];
+    size_t next = 0;
+    bool first = true;
+    while (first || next < edges.size()) {
+        token.check();
+        size_t count = 0;
+        if (first) {
+            parts[count++] = {header.data(), header.size()};
+            first = false;
+        }
+        for (size_t b = 0; b < EXPORT_BUFFERS && next < edges.size(); ++b) {
+            parts[count++] = {buffers[b].data(), encodeEdges(edges, next, buffers[b], binary)};
+        }
+        co_await conn.sendv(parts, count);
+    }
+}
+
+Task<void> ClientSession::createGraph(std::istringstream& args)
+{
+    std::string name = readWord(args, "name");
+    int vertices = readInt(args, "n");
+    checkVertexCount(vertices);
+
+    // Allocating the adjacency matrix is O(n^2), keep it off the reactor
+    std::shared_ptr<SharedGraph> created = co_await compute(stages.graph, "graph.create", [this, &name, vertices]() {
+        return registry.create(name, vertices);
+    });
+    attach(name, std::move(created));
+    co_await conn.send("Created and attached to " + describe(graphName, *graph->snapshot()) + "\n");
+}
+
+Task<void> ClientSession::attachGraph(std::istringstream& args)
+{
+    std::string name = readWord(args, "name");
+    std::shared_ptr<SharedGraph> found = registry.find(name);
+    if (!found) {
+        throw std::invalid_argument("No graph named '" + name + "'");
+    }
+    attach(name, std::move(found));
+    co_await conn.send("Attached to " + describe(graphName, *graph->snapshot()) + "\n");
+}
+
+Task<void> ClientSession::generate(std::istringstream& args)
+{
+    // Everything after the command is the generator spec, except name=<graph> which shares the result
+    std::string name, word, specText;
+    while (args >> word) {
+        if (word.rfind("name=", 0) == 0) {
+            name = word.substr(5);
+        } else {
+            specText += word + " ";
+        }
+    }
+    GeneratorSpec spec = parseGeneratorSpec(specText);
+    checkVertexCount(spec.vertices);
+
+    // Generation polls the token per row, so a deadline or a hangup stops it part way
+    std::shared_ptr<SharedGraph> generated = co_await compute(stages.graph, "graph.generate", [this, &spec, &name]() {
+        Graph generatedGraph = generateGraph(spec, stages.pool, token);
+        auto shared = std::make_shared<SharedGraph>(std::move(generatedGraph));
+        if (!name.empty()) {
+            registry.add(name, shared);
+        }
+        return shared;
+    });
+    attach(name, std::move(generated));
+    co_await conn.send("Generated and attached to " + describe(graphName, *graph->snapshot()) + "\n");
+}
+
+Task<void> ClientSession::loadShm(std::istringstream& args)
+{
+    // The ring comes as a descriptor attached to the command, which only a client on this host can
+    // send over the Unix-domain socket. The server maps the very file the client sealed, by no name
+    // another process could swap.
+    int ring = conn.takeDescriptor();
+    if (ring < 0) {
+        throw std::invalid_argument("shm needs the ring's descriptor, sent with the command over the server's "
+                                    "Unix-domain socket (see mst_local)");
+    }
+    std::string name;
+    std::shared_ptr<SharedGraph> loaded;
+    try {
+        std::string word;
+        while (args >> word) {
+            if (word.rfind("name=", 0) != 0) {
+                throw std::invalid_argument("Unknown option '" + word + "' (name=)");
+            }
+            name = word.substr(5);
+        }
+
+        // The ring is read while the client is still writing it, so the edges never go through the
+        // socket. The read waits on the client, so it gets a thread of its own instead of holding up
+        // the graph stage every session shares.
+        loaded = co_await compute(ownThread, "graph.shm", [this, &name, ring]() {
+            auto shared = std::make_shared<SharedGraph>(readShmGraph(ring, MAX_VERTICES, token));
+            if (!name.empty()) {
+                registry.add(name, shared);
+            }
+            return shared;
+        });
+    } catch (...) {
+        close(ring);
+        throw;
+    }
+    close(ring);
+    attach(name, std::move(loaded));
+    co_await conn.send("Loaded and attached to " + describe(graphName, *graph->snapshot()) + "\n");
+}
+
+Task<void> ClientSession::listGraphs()
+{
+    std::string text = "----------Shared graphs----------\n";
+    for (const std::string& name : registry.names()) {
+        std::shared_ptr<SharedGraph> entry = registry.find(name);
+        if (entry) {
+            text += describe(name, *entry->snapshot()) + "\n";
+        }
+    }
+    co_await conn.send(std::move(text));
+}
+
+Task<void> ClientSession::dropGraph(std::istringstream& args)
+{
+    std::string name = readWord(args, "name");
+    if (!registry.remove(name)) {
+        throw std::invalid_argument("No graph named '" + name + "'");
+    }
+    // Attached sessions, this one included, hold the graph until they attach to another one
+    co_await conn.send("Dropped graph '" + name + "'\n");
+}
+
+Task<void> ClientSession::addEdge(std::istringstream& args)
+{
+    int from = readInt(args, "u");
+    int to = readInt(args, "v");
+    int weight = readInt(args, "w");
+    SharedGraph& target = requireGraph();
+
+    // Copy-on-write of the adjacency matrix, done on the graph stage
+    std::shared_ptr<const GraphSnapshot> published = co_await compute(stages.graph, "graph.addEdge", [&target, from, to, weight]() {
+        return target.addEdge(from, to, weight);
+    });
+    co_await conn.send("Edge from " + std::to_string(from) + " -> " + std::to_string(to) + " with weight " +
+                       std::to_string(weight) + " added (graph version " + std::to_string(published->version) + ")\n");
+}
+
+Task<void> ClientSession::removeEdge(std::istringstream& args)
+{
+    int from = readInt(args, "u");
+    int to = readInt(args, "v");
+    SharedGraph& target = requireGraph();
+
+    std::shared_ptr<const GraphSnapshot> published = co_await compute(stages.graph, "graph.removeEdge", [&target, from, to]() {
+        return target.removeEdge(from, to);
+    });
+    co_await conn.send("Edge from " + std::to_string(from) + " -> " + std::to_string(to) +
+                       " removed (graph version " + std::to_string(published->version) + ")\n");
+}
+
+Task<void> ClientSession::setDeadline(std::istringstream& args)
+{
+    int milliseconds = readInt(args, "ms");
+    if (milliseconds < 0) {
+        throw std::invalid_argument("Deadline must not be negative");
+    }
+    deadline = std::chrono::milliseconds(milliseconds);
+    std::string reply = "Deadline disabled\n";
+    if (milliseconds > 0) {
+        reply = "Deadline set to " + std::to_string(milliseconds) + " ms\n";
+    }
+    co_await conn.send(std::move(reply));
+}
+
+Task<bool> ClientSession::handleCommand(const std::string& line)
+{
+    std::istringstream args(line);
+    std::string command;
+    if (!(args >> command)) co_return true;
+
+    if (command == "new") {
+        co_await build_graph();
+        std::string algo = co_await conn.prompt("----------MST creation----------\nEnter the algorithm of MST (prim or boruvka): ");
+        restartDeadline();
+        // A cancelled step throws, so the later stages are never posted
+        co_await build_mst(algo);
+        co_await analyze_data();
+    } else if (command == "create") {
+        co_await createGraph(args);
+    } else if (command == "attach") {
+        co_await attachGraph(args);
+    } else if (command == "shm") {
+        co_await loadShm(args);
+    } else if (command == "generate") {
+        co_await generate(args);
+    } else if (command == "list") {
+        co_await listGraphs();
+    } else if (command == "drop") {
+        co_await dropGraph(args);
+    } else if (command == "addEdge") {
+        co_await addEdge(args);
+    } else if (command == "removeEdge") {
+        co_await removeEdge(args);
+    } else if (command == "mst") {
+        co_await build_mst(readWord(args, "algorithm"));
+    } else if (command == "forest") {
+        co_await build_forest(readWord(args, "algorithm"));
+    } else if (command == "query") {
+        co_await queryPairs(args);
+    } else if (command == "export") {
+        co_await exportMst(args);
+    } else if (command == "analyze") {
+        co_await analyze_data();
+    } else if (command == "approx") {
+        co_await analyzeApprox(args);
+    } else if (command == "deadline") {
+        co_await setDeadline(args);
+    } else if (command == "exit") {
+        co_return false;
+    } else {
+        co_await conn.send(std::string("Unknown command '") + command + "'\n" + MENU);
+    }
+    co_return true;
+}
+
+Task<void> ClientSession::run()
+{
+    co_await conn.send(MENU);
+    while (true) {
+        co_await conn.send("Enter a command: ");
+        std::optional<std::string> line = co_await conn.readLine();
+        if (!line) co_return;
+
+        // Bad input (logic errors: parsing, vertex ranges, ...) and cancelled computations fail
+        // the command, not the session
+        std::string error;
+        bool keepGoing = true;
+        {
+            token = CancelToken::withTimeout(deadline);
+            requestId = trace::nextRequest();
+            TRACE_ASYNC(line->substr(0, line->find(' ')), requestId);
+            HangupWatch watch(conn, [this]() {
+                hungUp = true;
+                token.cancel("Client disconnected");
+            });
+            try {
+                keepGoing = co_await handleCommand(*line);
+            } catch (const Cancelled& e) {
+                error = e.what();
+            } catch (const std::logic_error& e) {
+                error = e.what();
+            }
+        }
+        TRACE_FLUSH();
+        if (hungUp) co_return;
+        if (!error.empty()) {
+            co_await conn.send("Error: " + error + "\n");
+        }
+        if (!keepGoing) co_return;
+    }
+}
@@ -0,0 +1,116 @@
+#ifndef SESSION_HPP
+#define SESSION_HPP
+
+#include "cancel.hpp"
+#include "coroutine.hpp"
+#include "graph_registry.hpp"
+#include "mst.hpp"
+#include "reactor.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+
+/**
+ * Class: Executor
+ * Type-erased handle to something that runs jobs on its own threads: an ActiveObject
+ * stage, the leader-follower worker pool, ...
+ */
+class Executor {
+public:
+    using Job = std::function<void()>;
+
+    explicit Executor(std::function<void(Job)> postFn) : postFn(std::move(postFn)) {}
+
+    // Wraps any object with a post(std::function<void()>) member
+    template <typename Target>
+    static Executor of(Target& target)
+    {
+        return Executor([&target](Job job) { target.post(std::move(job)); });
+    }
+
+    void post(Job job) { postFn(std::move(job)); }
+
+private:
+    std::function<void(Job)> postFn;
+};
+
+// Where each kind of session work runs. The pipeline server maps these to its three
+// stages, the leader-follower server sends everything to its worker pool. Jobs that split
+// their work (forest, queries, sampling, generation) fan it out over pool, one per shard.
+struct SessionStages {
+    Executor graph;      // Building and mutating graphs
+    Executor mst;        // MST computation
+    Executor analysis;   // Analytics on a computed MST
+    ThreadPool& pool;    // Data-parallel helpers of the jobs above
+};
+
+/**
+ * Class: ClientSession
+ * The command loop of one client connection. Runs on the reactor thread and hands all
+ * compute work to the stages. A session is attached to one graph at a time: either a
+ * private graph built with "new" or a named graph from the registry.
+ * Every command gets a cancel token: it expires after the session's deadline, counted from
+ * the moment the command's input is complete, and is cancelled if the client hangs up. Stage
+ * jobs that start after that are skipped and running computations stop at their next check.
+ */
+class ClientSession {
+public:
+    // deadline: time limit of every command's computation, zero for none
+    ClientSession(Connection& conn, GraphRegistry& registry, SessionStages& stages,
+                  std::chrono::milliseconds deadline = std::chrono::milliseconds(0));
+
+    // Serves commands until the client exits or disconnects
+    Task<void> run();
+
+private:
+    Connection& conn;
+    GraphRegistry& registry;
+    SessionStages& stages;
+
+    std::string graphName;                 // Empty for a private graph
+    std::shared_ptr<SharedGraph> graph;    // Graph the session is attached to
+    std::shared_ptr<MST> mst;              // Last MST computed by this session
+    uint64_t mstVersion = 0;               // Graph version the MST was computed from
+    std::chrono::milliseconds deadline;    // Time limit of each command, zero for none
+    CancelToken token;                     // Token of the command being served
+    bool hungUp = false;                   // The client went away during a command
+    uint64_t requestId = 0;                // Trace id of the command being served
+
+    // Guided flow of the original protocol: graph, MST, analysis
+    Task<void> build_graph();
+    Task<void> build_mst(std::string algo);
+    Task<void> analyze_data();
+    Task<void> analyzeApprox(std::istringstream& args);
+    Task<void> build_forest(std::string algo);
+    Task<void> queryPairs(std::istringstream& args);
+    Task<void> exportMst(std::istringstream& args);
+
+    Task<void> createGraph(std::istringstream& args);
+    Task<void> attachGraph(std::istringstream& args);
+    Task<void> generate(std::istringstream& args);
+    Task<void> loadShm(std::istringstream& args);
+    Task<void> listGraphs();
+    Task<void> dropGraph(std::istringstream& args);
+    Task<void> addEdge(std::istringstream& args);
+    Task<void> removeEdge(std::istringstream& args);
+    Task<void> setDeadline(std::istringstream& args);
+
+    // Awaitable running fn on stage for the current command (see session.cpp)
+    template <typename F>
+    auto compute(Executor& stage, const char* name, F&& fn);
+
+    // Executes one command line; returns false when the client asked to exit
+    Task<bool> handleCommand(const std::string& line);
+
+    // Starts the deadline of the current command over, once its input has been read
+    void restartDeadline();
+    void attach(const std::string& name, std::shared_ptr<SharedGraph> target);
+    SharedGraph& requireGraph() const;
+    MST& requireMst() const;
+};
+
+#endif // SESSION_HPP
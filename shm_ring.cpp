@@ -0,0 +1,246 @@
+#include "shm_ring.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#define SHM_RING_MAGIC 0x5453454du // "MEST"
+#define SHM_RING_VERSION 3
+#define SHM_SPINS 1024             // Polls with yield before sleeping between polls
+#define SHM_SLEEP_US 50            // Sleep between polls once spinning did not help
+#define SHM_READ_BATCH 4096        // Edges consumed between two tail updates and token checks
+#define SHM_SIZE_SEALS (F_SEAL_SHRINK | F_SEAL_GROW) // Seals the reader requires on a ring
+
+using Clock = std::chrono::steady_clock;
+
+static size_t segmentBytes(uint32_t capacity)
+{
+    return sizeof(ShmRingHeader) + static_cast<size_t>(capacity) * sizeof(ShmEdge);
+}
+
+/**
+ * Class: Waiter
+ * Polls for the other side of the ring: yields for the first SHM_SPINS polls (the other side
+ * is usually just behind), then sleeps SHM_SLEEP_US between polls. pause() returns false once
+ * nothing moved for stallMs.
+ */
+class Waiter {
+public:
+    explicit Waiter(int stallMs) : stallLimit(stallMs), lastProgress(Clock::now()) {}
+
+    void progressed()
+    {
+        spins = 0;
+        lastProgress = Clock::now();
+    }
+
+    bool pause()
+    {
+        if (spins < SHM_SPINS) {
+            ++spins;
+            std::this_thread::yield();
+            return true;
+        }
+        if (Clock::now() - lastProgress > stallLimit) return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(SHM_SLEEP_US));
+        return true;
+    }
+
+private:
+    std::chrono::milliseconds stallLimit;
+    int spins = 0;
+    Clock::time_point lastProgress;
+};
+
+// Constructor: creates, sizes, seals and maps the memory file, then sets up an empty ring
+ShmEdgeWriter::ShmEdgeWriter(int vertices, uint32_t capacity) : mappedBytes(segmentBytes(capacity))
+{
+    if (vertices < 0 || capacity == 0) {
+        throw std::invalid_argument("Shared memory ring needs vertices >= 0 and a capacity > 0");
+    }
+    fd = memfd_create("mst_edges", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("memfd_create failed: ") + strerror(errno));
+    }
+    // F_SEAL_SEAL last: once sized, the ring can get no other seal that would upset the server
+    void* memory = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(mappedBytes)) == 0 &&
+        fcntl(fd, F_ADD_SEALS, SHM_SIZE_SEALS | F_SEAL_SEAL) == 0) {
+        memory = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (memory == MAP_FAILED) {
+        int error = errno;
+        ::close(fd);
+        throw std::runtime_error(std::string("Setting up the shared memory ring failed: ") + strerror(error));
+    }
+
+    header = new (memory) ShmRingHeader();
+    header->version = SHM_RING_VERSION;
+    header->vertices = vertices;
+    header->capacity = capacity;
+    slots = reinterpret_cast<ShmEdge*>(header + 1);
+    header->magic = SHM_RING_MAGIC; // The reader opens the ring only after the client's command
+}
+
+ShmEdgeWriter::~ShmEdgeWriter()
+{
+    header->~ShmRingHeader();
+    munmap(header, mappedBytes);
+    ::close(fd);
+}
+
+void ShmEdgeWriter::write(const ShmEdge* edges, size_t count)
+{
+    TRACE_SPAN("shm.write");
+    if (closed) {
+        throw std::logic_error("Shared memory ring already closed");
+    }
+    uint64_t capacity = header->capacity;
+    uint64_t head = header->head.load(std::memory_order_relaxed);
+    Waiter waiter(SHM_WRITER_STALL_MS);
+    while (count > 0) {
+        if (header->aborted.load(std::memory_order_acquire)) {
+            throw std::runtime_error("The server gave up on the shared memory ring");
+        }
+        uint64_t free = capacity - (head - header->tail.load(std::memory_order_acquire));
+        if (free == 0) {
+            if (!waiter.pause()) throw std::runtime_error("Shared memory ring stalled: the server stopped reading");
+            continue;
+        }
+        waiter.progressed();
+
+        // Copy up to the end of the free space, in at most two pieces around the wrap
+        size_t batch = static_cast<size_t>(std::min<uint64_t>(free, count));
+        size_t first = std::min<size_t>(batch, static_cast<size_t>(capacity - head % capacity));
+        memcpy(slots + head % capacity, edges, first * sizeof(ShmEdge));
+        memcpy(slots, edges + first, (batch - first) * sizeof(ShmEdge));
+        head += batch;
+        header->head.store(head, std::memory_order_release);
+        edges += batch;
+        count -= batch;
+    }
+}
+
+void ShmEdgeWriter::write(int u, int v, int w)
+{
+    ShmEdge edge{u, v, w};
+    write(&edge, 1);
+}
+
+void ShmEdgeWriter::close()
+{
+    closed = true;
+    header->closed.store(1, std::memory_order_release);
+}
+
+/**
+ * Class: ShmMapping
+ * Read-write mapping of a ring received from a client, unmapped on destruction. The client keeps
+ * the file too: without the size seals it could truncate the file and turn every later access to
+ * the mapping into SIGBUS, so an unsealed file is refused.
+ */
+class ShmMapping {
+public:
+    explicit ShmMapping(int fd)
+    {
+        int seals = fcntl(fd, F_GET_SEALS);
+        if (seals < 0 || (seals & SHM_SIZE_SEALS) != SHM_SIZE_SEALS) {
+            throw std::invalid_argument("The shared memory ring must be a memfd sealed against shrinking and growing");
+        }
+        struct stat info;
+        if (fstat(fd, &info) < 0 || !S_ISREG(info.st_mode) ||
+            static_cast<size_t>(info.st_size) < sizeof(ShmRingHeader)) {
+            throw std::invalid_argument("The shared memory file is not an edge ring");
+        }
+        bytes = static_cast<size_t>(info.st_size);
+        memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (memory == MAP_FAILED) {
+            throw std::invalid_argument(std::string("Mapping the shared memory ring failed: ") + strerror(errno));
+        }
+    }
+
+    ~ShmMapping() { munmap(memory, bytes); }
+    ShmMapping(const ShmMapping&) = delete;
+    ShmMapping& operator=(const ShmMapping&) = delete;
+
+    void* memory;
+    size_t bytes;
+};
+
+Graph readShmGraph(int fd, int maxVertices, const CancelToken& token)
+{
+    TRACE_SPAN("shm.read");
+    ShmMapping mapping(fd);
+    ShmRingHeader* header = static_cast<ShmRingHeader*>(mapping.memory);
+    const ShmEdge* slots = reinterpret_cast<const ShmEdge*>(header + 1);
+
+    // The client writes the ring too: copy the layout once and never trust it past the mapping
+    uint32_t capacity = header->capacity;
+    int vertices = header->vertices;
+    if (header->magic != SHM_RING_MAGIC || header->version != SHM_RING_VERSION || capacity == 0 ||
+        segmentBytes(capacity) > mapping.bytes || vertices < 0) {
+        throw std::invalid_argument("The shared memory file is not an edge ring");
+    }
+    // One reader per ring: a second one would take edges out from under the first
+    uint32_t unclaimed = 0;
+    if (!header->claimed.compare_exchange_strong(unclaimed, 1, std::memory_order_acq_rel)) {
+        throw std::invalid_argument("The shared memory ring already has a reader");
+    }
+
+    try {
+        // The graph is an n x n matrix: check the announced size before allocating it
+        if (vertices > maxVertices) {
+            throw std::invalid_argument("The shared memory ring announces " + std::to_string(vertices) +
+                                        " vertices, more than the limit of " + std::to_string(maxVertices));
+        }
+        Graph graph(vertices);
+        uint64_t tail = header->tail.load(std::memory_order_relaxed);
+        Waiter waiter(SHM_READER_STALL_MS);
+        while (true) {
+            token.check();
+            uint64_t head = header->head.load(std::memory_order_acquire);
+            if (head - tail > capacity) {
+                throw std::invalid_argument("The shared memory ring is corrupt");
+            }
+            if (head == tail) {
+                // closed is set after the last head update, so check head again once it is seen
+                if (header->closed.load(std::memory_order_acquire) &&
+                    header->head.load(std::memory_order_acquire) == tail) {
+                    break;
+                }
+                if (!waiter.pause()) {
+                    throw std::invalid_argument("The shared memory ring stalled: the client stopped writing");
+                }
+                continue;
+            }
+            waiter.progressed();
+
+            uint64_t end = std::min<uint64_t>(head, tail + SHM_READ_BATCH);
+            for (; tail < end; ++tail) {
+                ShmEdge edge = slots[tail % capacity];
+                try {
+                    graph.addEdge(edge.u, edge.v, edge.w);
+                } catch (const std::logic_error& e) {
+                    throw std::invalid_argument("Edge " + std::to_string(tail) + " (" + std::to_string(edge.u) + " " +
+                                                std::to_string(edge.v) + " " + std::to_string(edge.w) +
+                                                "): " + e.what());
+                }
+            }
+            header->tail.store(tail, std::memory_order_release);
+        }
+        return graph;
+    } catch (...) {
+        header->aborted.store(1, std::memory_order_release);
+        throw;
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef SHM_RING_HPP
+#define SHM_RING_HPP
+
+#include "cancel.hpp"
+#include "graph.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#define SHM_RING_EDGES 65536      // Default capacity of a ring, in edges (768 KiB of records)
+#define SHM_READER_STALL_MS 5000  // The server gives up when the client writes nothing for this long
+#define SHM_WRITER_STALL_MS 30000 // The client gives up when the server drains nothing for this long
+
+// One edge record in the ring: three int32 values, like the binary export
+struct ShmEdge {
+    int32_t u;
+    int32_t v;
+    int32_t w;
+};
+
+/**
+ * Struct: ShmRingHeader
+ * Start of a shared-memory edge ring, followed by capacity ShmEdge slots. One writer (the
+ * client) and one reader (the server) share it without locks: the writer fills slots and
+ * publishes them by advancing head, the reader consumes them and frees them by advancing tail.
+ * Both counters only grow; slot i lives at i % capacity. The counters sit on their own cache
+ * lines so the two sides do not invalidate each other's line on every edge.
+ */
+struct ShmRingHeader {
+    uint32_t magic;                           // SHM_RING_MAGIC once the writer has set the ring up
+    uint32_t version;
+    int32_t vertices;                         // Vertices of the graph being sent
+    uint32_t capacity;                        // Slots in the ring
+    alignas(64) std::atomic<uint64_t> head;   // Edges written (writer only)
+    alignas(64) std::atomic<uint64_t> tail;   // Edges consumed (reader only)
+    alignas(64) std::atomic<uint32_t> closed; // Set by the writer after its last edge
+    std::atomic<uint32_t> aborted;            // Set by the reader when it gives up on the ring
+    std::atomic<uint32_t> claimed;            // Set by the one reader allowed to consume the ring
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The ring counters must be lock-free to be shared");
+
+/**
+ * Class: ShmEdgeWriter
+ * Client side of the ring: creates an anonymous memory file (memfd) of the ring's size, seals its
+ * size so that neither side can shrink or grow it later, then streams edges into it while the
+ * server builds the graph. The server gets the ring as descriptor(), sent over a Unix-domain
+ * socket (SCM_RIGHTS). Throws runtime_error if the ring cannot be created, if the server gives up
+ * on the ring, or if the server does not drain a full ring for SHM_WRITER_STALL_MS.
+ */
+class ShmEdgeWriter {
+public:
+    ShmEdgeWriter(int vertices, uint32_t capacity = SHM_RING_EDGES);
+    ~ShmEdgeWriter();
+    ShmEdgeWriter(const ShmEdgeWriter&) = delete;
+    ShmEdgeWriter& operator=(const ShmEdgeWriter&) = delete;
+
+    int descriptor() const { return fd; }
+
+    // Appends edges[0..count), waiting for the reader while the ring is full
+    void write(const ShmEdge* edges, size_t count);
+    void write(int u, int v, int w);
+    // Marks the end of the edge list; the reader returns once it has consumed everything
+    void close();
+
+private:
+    int fd;
+    ShmRingHeader* header;
+    ShmEdge* slots;
+    size_t mappedBytes;
+    bool closed = false;
+};
+
+/**
+ * Function: readShmGraph
+ * Server side of the ring: maps the ring a client created with ShmEdgeWriter and sent as the
+ * descriptor fd, and builds the graph from its edges as they arrive, until the writer closes the
+ * ring. Only a ring whose size is sealed (the client could otherwise truncate it under the
+ * mapping), that announces at most maxVertices vertices and that no other reader claimed is
+ * accepted. fd stays open. Polls token between batches. Throws invalid_argument if the ring is
+ * unsealed, malformed, too large or already read, on a bad edge, or when the writer stalls for
+ * SHM_READER_STALL_MS (marking the ring aborted so the writer stops), and Cancelled if token is
+ * cancelled.
+ */
+Graph readShmGraph(int fd, int maxVertices, const CancelToken& token = CancelToken());
+
+#endif // SHM_RING_HPP
@@ -0,0 +1,36 @@
+#ifndef TESTS_CHECK_HPP
+#define TESTS_CHECK_HPP
+
+#include <iostream>
+
+// Minimal assertions for the test programs: a failed CHECK prints its location and the test
+// exits non-zero at the end, so one run reports every failure.
+inline int checkFailures = 0;
+
+#define CHECK(condition)                                                                   \
+    do {                                                                                   \
+        if (!(condition)) {                                                                \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition "\n"; \
+            ++checkFailures;                                                               \
+        }                                                                                  \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                          \
+    do {                                                                                    \
+        auto checkActual = (actual);                                                        \
+        auto checkExpected = (expected);                                                    \
+        if (!(checkActual == checkExpected)) {                                              \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQ failed: " #actual " is " \
+                      << checkActual << ", expected " << checkExpected << "\n";             \
+            ++checkFailures;                                                                \
+        }                                                                                   \
+    } while (0)
+
+// Exit status of a test program
+inline int checkResult(const char* name)
+{
+    std::cout << name << (checkFailures == 0 ? ": passed\n" : ": FAILED\n");
+    return checkFailures == 0 ? 0 : 1;
+}
+
+#endif // TESTS_CHECK_HPP
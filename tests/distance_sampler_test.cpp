@@ -0,0 +1,94 @@
+#include "check.hpp"
+#include "distance_sampler.hpp"
+#include "generator.hpp"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// Exact average shortest-path distance over the connected pairs, by Floyd-Warshall
+static double exactAverage(const Graph& graph)
+{
+    const long long unreachable = std::numeric_limits<long long>::max() / 4;
+    int n = graph.getVertexCount();
+    std::vector<std::vector<long long>> dist(n, std::vector<long long>(n, unreachable));
+    for (int u = 0; u < n; ++u) {
+        dist[u][u] = 0;
+        for (int v = 0; v < n; ++v) {
+            if (graph.row(u)[v] != 0) dist[u][v] = graph.row(u)[v];
+        }
+    }
+    for (int k = 0; k < n; ++k) {
+        for (int u = 0; u < n; ++u) {
+            for (int v = 0; v < n; ++v) {
+                dist[u][v] = std::min(dist[u][v], dist[u][k] + dist[k][v]);
+            }
+        }
+    }
+    double sum = 0;
+    long long pairs = 0;
+    for (int u = 0; u < n; ++u) {
+        for (int v = 0; v < n; ++v) {
+            if (u == v || dist[u][v] >= unreachable) continue;
+            sum += static_cast<double>(dist[u][v]);
+            ++pairs;
+        }
+    }
+    return sum / static_cast<double>(pairs);
+}
+
+// A 95% interval misses now and then, so over many seeds the partial estimate must cover the
+// exact average most of the time; sampling every source gives the exact value
+static void testCoverage(const char* text, ThreadPool& pool)
+{
+    Graph graph = generateGraph(parseGeneratorSpec(text), pool);
+    double exact = exactAverage(graph);
+    const int seeds = 40;
+    int covered = 0;
+    for (int seed = 1; seed <= seeds; ++seed) {
+        DistanceSampler sampler(graph, seed, pool);
+        DistanceEstimate estimate = sampler.step(graph.getVertexCount() / 5);
+        CHECK(!estimate.exact);
+        CHECK(std::isfinite(estimate.halfWidth) && estimate.halfWidth > 0);
+        if (std::fabs(estimate.average - exact) <= estimate.halfWidth) ++covered;
+
+        while (!sampler.finished()) estimate = sampler.step();
+        CHECK(estimate.exact);
+        CHECK_EQ(estimate.halfWidth, 0.0);
+        CHECK(std::fabs(estimate.average - exact) <= 1e-9 * exact);
+    }
+    if (covered < seeds * 85 / 100) {
+        std::cerr << text << ": interval covered the exact average for " << covered << "/" << seeds << " seeds\n";
+        ++checkFailures;
+    }
+}
+
+// Isolated sources reach no pair: the error stays unknown instead of looking converged
+static void testNoReachablePairs(ThreadPool& pool)
+{
+    Graph edgeless(50);
+    DistanceSampler sampler(edgeless, 1, pool);
+    DistanceEstimate estimate = sampler.step(40);
+    CHECK(!estimate.exact);
+    CHECK(std::isinf(estimate.relativeError()));
+
+    // One edge among many isolated vertices: sources that miss it must not end the sampling
+    Graph sparse(200);
+    sparse.addEdge(0, 1, 5);
+    DistanceSampler sparseSampler(sparse, 1, pool);
+    estimate = sparseSampler.step(30);
+    if (estimate.average == 0) CHECK(std::isinf(estimate.relativeError()));
+    while (!sparseSampler.finished()) estimate = sparseSampler.step();
+    CHECK_EQ(estimate.average, 5.0);
+    CHECK_EQ(estimate.relativeError(), 0.0);
+}
+
+int main()
+{
+    ThreadPool pool(4);
+    testCoverage("random n=200 m=600 seed=21", pool);
+    testCoverage("grid rows=12 cols=15 seed=22", pool);
+    testCoverage("random n=200 m=150 seed=23", pool); // Several components
+    testNoReachablePairs(pool);
+    return checkResult("distance_sampler_test");
+}
@@ -0,0 +1,97 @@
+#include "check.hpp"
+#include "external_mst.hpp"
+#include "generator.hpp"
+#include "mst.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+#define RECORD_BYTES 12 // One int32 (u, v, w) record, the size of an edge in a run
+
+using EdgeList = std::vector<std::tuple<int, int, int>>;
+
+static std::string tempPath(const char* name)
+{
+    return "/tmp/external_mst_test_" + std::to_string(getpid()) + "_" + name;
+}
+
+static void writeText(const std::string& path, const EdgeList& edges)
+{
+    std::ofstream out(path);
+    for (const auto& [u, v, w] : edges) out << u << " " << v << " " << w << "\n";
+}
+
+static void writeBinary(const std::string& path, const EdgeList& edges)
+{
+    std::ofstream out(path, std::ios::binary);
+    for (const auto& [u, v, w] : edges) {
+        int32_t record[3] = {u, v, w};
+        out.write(reinterpret_cast<const char*>(record), sizeof(record));
+    }
+}
+
+// Total weight of the in-memory prim MST of the graph
+static long long primWeight(const EdgeList& edges, int n)
+{
+    Graph graph(n);
+    for (const auto& [u, v, w] : edges) graph.addEdge(u, v, w);
+    MST tree(graph, "prim");
+    return tree.getTotalWeight();
+}
+
+// Runs externalMst with a budget of runEdges edges per run and checks it against prim
+static void checkAgainstPrim(const char* specText, size_t runEdges, bool binary, bool exactMultiple)
+{
+    GeneratorSpec spec = parseGeneratorSpec(specText);
+    EdgeList edges = generateEdges(spec);
+    if (exactMultiple) {
+        edges.resize(edges.size() / runEdges * runEdges);
+    }
+    std::string input = tempPath("edges"), treeFile = tempPath("tree");
+    binary ? writeBinary(input, edges) : writeText(input, edges);
+
+    ExternalMstOptions options;
+    options.memoryBudget = runEdges * RECORD_BYTES; // Under 2 MiB the whole budget goes to the runs
+    options.binaryInput = binary;
+    options.vertices = spec.vertices;
+    ExternalMstStats stats = externalMst(input, treeFile, options);
+
+    CHECK_EQ(stats.edges, edges.size());
+    // An input smaller than one run stays in memory
+    CHECK_EQ(stats.runs, edges.size() < runEdges ? 0 : (edges.size() + runEdges - 1) / runEdges);
+    CHECK_EQ(stats.totalWeight, primWeight(edges, spec.vertices));
+    CHECK_EQ(stats.treeEdges, static_cast<uint64_t>(spec.vertices - stats.components));
+
+    // The tree file holds exactly the reported tree
+    std::ifstream tree(treeFile);
+    long long weight = 0;
+    uint64_t lines = 0;
+    int u, v, w;
+    while (tree >> u >> v >> w) {
+        weight += w;
+        ++lines;
+    }
+    CHECK_EQ(lines, stats.treeEdges);
+    CHECK_EQ(weight, stats.totalWeight);
+
+    std::remove(input.c_str());
+    std::remove(treeFile.c_str());
+}
+
+int main()
+{
+    // Several runs and merge passes, with a partial last run
+    checkAgainstPrim("random n=400 m=6000 seed=21", 700, false, false);
+    // Edge count an exact multiple of the run size: no partial last run
+    checkAgainstPrim("random n=400 m=6000 seed=22", 500, true, true);
+    // Disconnected graph: a spanning forest
+    checkAgainstPrim("geometric n=500 r=0.05 seed=23", 256, false, false);
+    // Everything fits in one buffer: no run is written
+    checkAgainstPrim("grid rows=20 cols=20 seed=24", 100000, true, false);
+    return checkResult("external_mst_test");
+}
@@ -0,0 +1,124 @@
+#include "check.hpp"
+#include "forest.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using Edge = std::tuple<int, int, int, int>;
+
+static void addEdge(std::vector<Edge>& edges, int u, int v, int w)
+{
+    edges.emplace_back(u, v, w, static_cast<int>(edges.size()));
+}
+
+// Kruskal over the whole edge list: weight of the minimum spanning forest
+static long long referenceWeight(std::vector<Edge> edges, int n)
+{
+    std::vector<int> parent(n);
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&parent](int v) {
+        while (parent[v] != v) v = parent[v] = parent[parent[v]];
+        return v;
+    };
+    std::sort(edges.begin(), edges.end(),
+              [](const Edge& a, const Edge& b) { return std::get<2>(a) < std::get<2>(b); });
+    long long total = 0;
+    for (const Edge& edge : edges) {
+        int a = find(std::get<0>(edge)), b = find(std::get<1>(edge));
+        if (a != b) {
+            parent[a] = b;
+            total += std::get<2>(edge);
+        }
+    }
+    return total;
+}
+
+// Three components and an isolated vertex, with known trees
+static void testKnownForest(const std::string& algo, ThreadPool& pool)
+{
+    std::vector<Edge> edges;
+    addEdge(edges, 0, 1, 4); // Triangle 0-1-2: tree 1-2 (2) + 0-1 (4)
+    addEdge(edges, 1, 2, 2);
+    addEdge(edges, 0, 2, 5);
+    addEdge(edges, 3, 4, 7); // Single edge
+    addEdge(edges, 6, 7, 1); // Path 6-7-8-9 plus a heavy chord
+    addEdge(edges, 7, 8, 3);
+    addEdge(edges, 8, 9, 2);
+    addEdge(edges, 6, 9, 10);
+
+    SpanningForest forest = spanningForest(edges, 10, algo, pool);
+    CHECK_EQ(forest.components.size(), 4u);
+    CHECK_EQ(forest.edges.size(), 6u);
+    CHECK_EQ(forest.componentOf[0], forest.componentOf[2]);
+    CHECK(forest.componentOf[0] != forest.componentOf[3]);
+    CHECK(forest.componentOf[5] != forest.componentOf[6]);
+    if (forest.components.size() != 4) return;
+
+    const ComponentStats& triangle = forest.components[0];
+    CHECK_EQ(triangle.root, 0);
+    CHECK_EQ(triangle.vertices, 3);
+    CHECK_EQ(triangle.edges, 2);
+    CHECK_EQ(triangle.totalWeight, 6);
+    CHECK_EQ(triangle.diameter, 6);
+    CHECK_EQ(triangle.maxEdgeWeight, 4);
+
+    const ComponentStats& pair = forest.components[1];
+    CHECK_EQ(pair.root, 3);
+    CHECK_EQ(pair.vertices, 2);
+    CHECK_EQ(pair.totalWeight, 7);
+    CHECK_EQ(pair.diameter, 7);
+
+    const ComponentStats& single = forest.components[2];
+    CHECK_EQ(single.root, 5);
+    CHECK_EQ(single.vertices, 1);
+    CHECK_EQ(single.edges, 0);
+    CHECK_EQ(single.totalWeight, 0);
+    CHECK_EQ(single.maxEdgeWeight, 0);
+
+    const ComponentStats& path = forest.components[3];
+    CHECK_EQ(path.root, 6);
+    CHECK_EQ(path.vertices, 4);
+    CHECK_EQ(path.totalWeight, 6);
+    CHECK_EQ(path.diameter, 6);
+    CHECK_EQ(path.maxEdgeWeight, 3);
+}
+
+// Random sparse graph with many components: the forest weight matches Kruskal's
+static void testRandomForest(const std::string& algo, ThreadPool& pool)
+{
+    const int n = 2000;
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> vertex(0, n - 1), weight(1, 100);
+    std::vector<Edge> edges;
+    for (int i = 0; i < n * 3 / 4; ++i) {
+        int u = vertex(random), v = vertex(random);
+        if (u != v) addEdge(edges, std::min(u, v), std::max(u, v), weight(random));
+    }
+
+    SpanningForest forest = spanningForest(edges, n, algo, pool);
+    long long total = 0;
+    int vertices = 0;
+    for (const ComponentStats& component : forest.components) {
+        total += component.totalWeight;
+        vertices += component.vertices;
+        CHECK_EQ(component.edges, component.vertices - 1);
+    }
+    CHECK_EQ(total, referenceWeight(edges, n));
+    CHECK_EQ(vertices, n);
+    CHECK_EQ(forest.edges.size(), static_cast<size_t>(n) - forest.components.size());
+}
+
+int main()
+{
+    ThreadPool single(1), several(4);
+    for (const std::string algo : {"prim", "boruvka"}) {
+        testKnownForest(algo, single);
+        testKnownForest(algo, several);
+        testRandomForest(algo, several);
+    }
+    return checkResult("forest_test");
+}
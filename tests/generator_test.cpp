@@ -0,0 +1,84 @@
+#include "check.hpp"
+#include "generator.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using EdgeList = std::vector<std::tuple<int, int, int>>;
+
+static const char* SPECS[] = {
+    "random n=500 m=3000 seed=11", "grid rows=20 cols=30 seed=12", "geometric n=400 r=0.1 seed=13",
+    "powerlaw n=400 deg=6 seed=14", "complete n=60 w=5..9 seed=15",
+};
+
+// The same spec gives the same edges, whatever the number of threads
+static void testDeterministic(ThreadPool& single, ThreadPool& several)
+{
+    for (const char* text : SPECS) {
+        GeneratorSpec spec = parseGeneratorSpec(text);
+        EdgeList first = generateEdges(spec, single);
+        EdgeList second = generateEdges(spec, several);
+        EdgeList third = generateEdges(spec, several);
+        CHECK(!first.empty());
+        CHECK(first == second);
+        CHECK(second == third);
+
+        for (const auto& [u, v, w] : first) {
+            CHECK(u >= 0 && u < v && v < spec.vertices);
+            CHECK(w >= spec.minWeight && w <= spec.maxWeight);
+        }
+
+        // The graph holds exactly the generated edges
+        Graph graph = generateGraph(spec, several);
+        CHECK_EQ(graph.getVertexCount(), spec.vertices);
+        CHECK_EQ(static_cast<size_t>(graph.getEdgeCount()), first.size());
+    }
+}
+
+static void testSeedMatters(ThreadPool& pool)
+{
+    EdgeList a = generateEdges(parseGeneratorSpec("random n=500 m=3000 seed=1"), pool);
+    EdgeList b = generateEdges(parseGeneratorSpec("random n=500 m=3000 seed=2"), pool);
+    CHECK_EQ(a.size(), 3000u);
+    CHECK(a != b);
+}
+
+static void testRejectedSpecs()
+{
+    const char* bad[] = {"random n=10 m=46", "grid rows=100000 cols=100000", "random n=5000000000",
+                         "powerlaw n=10 exp=1", "complete n=10 w=0..5", "tree n=10", "random n=10 q=1"};
+    for (const char* text : bad) {
+        bool rejected = false;
+        try {
+            parseGeneratorSpec(text);
+        } catch (const std::invalid_argument&) {
+            rejected = true;
+        }
+        CHECK(rejected);
+    }
+}
+
+static void testCancelled(ThreadPool& pool)
+{
+    CancelToken token = CancelToken::withTimeout(std::chrono::milliseconds(1));
+    token.cancel("test");
+    bool cancelled = false;
+    try {
+        generateGraph(parseGeneratorSpec("complete n=2000"), pool, token);
+    } catch (const Cancelled&) {
+        cancelled = true;
+    }
+    CHECK(cancelled);
+}
+
+int main()
+{
+    ThreadPool single(1), several(4);
+    testDeterministic(single, several);
+    testSeedMatters(several);
+    testRejectedSpecs();
+    testCancelled(several);
+    return checkResult("generator_test");
+}
@@ -0,0 +1,130 @@
+#include "check.hpp"
+#include "graph_registry.hpp"
+#include "reactor.hpp"
+#include "session.hpp"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+
+// Runs one session on the reactor and stops the reactor once the session is over
+static Task<void> serve(Reactor& reactor, int fd, GraphRegistry& registry, SessionStages& stages)
+{
+    {
+        Connection conn(reactor, fd);
+        ClientSession session(conn, registry, stages, std::chrono::milliseconds(0));
+        try {
+            co_await session.run();
+        } catch (const std::exception&) {
+            // A vanished client may fail the last send
+        }
+    }
+    reactor.stop();
+}
+
+// Blocking loopback TCP connection: {client fd, server fd}
+static std::pair<int, int> connectLoopback()
+{
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    listen(listener, 1);
+    getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    int server = accept(listener, nullptr, nullptr);
+    close(listener);
+    return {client, server};
+}
+
+static void sendText(int fd, const std::string& text)
+{
+    send(fd, text.data(), text.size(), MSG_NOSIGNAL);
+}
+
+// Reads until marker has been received count times, or the server closes
+static std::string readUntil(int fd, const std::string& marker, int count)
+{
+    std::string text;
+    char buffer[65536];
+    auto seen = [&]() {
+        int found = 0;
+        for (size_t at = text.find(marker); at != std::string::npos; at = text.find(marker, at + 1)) ++found;
+        return found;
+    };
+    while (seen() < count) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) break;
+        text.append(buffer, n);
+    }
+    return text;
+}
+
+/**
+ * A client that closes normally (FIN only, no reset) while its analyze runs. Floyd-Warshall on
+ * 1500 vertices takes tens of seconds, so the session ending within a couple of seconds means
+ * the hangup cancelled it.
+ */
+static void testCloseCancelsAnalyze(GraphRegistry& registry, SessionStages& stages)
+{
+    Reactor reactor;
+    auto [client, server] = connectLoopback();
+    spawn(serve(reactor, server, registry, stages));
+    std::thread loop([&reactor]() { reactor.run(); });
+
+    readUntil(client, "Enter a command: ", 1);
+    sendText(client, "generate random n=1500 m=20000 seed=1\n");
+    readUntil(client, "Enter a command: ", 1);
+    sendText(client, "mst prim\n");
+    std::string reply = readUntil(client, "Enter a command: ", 1);
+    CHECK(reply.find("MST created") != std::string::npos);
+    sendText(client, "analyze\n");
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+    Clock::time_point closed = Clock::now();
+    close(client);
+    loop.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - closed).count();
+    std::cout << "analyze stopped " << seconds << " s after the client closed\n";
+    CHECK(seconds < 3.0);
+}
+
+/**
+ * A client that sends all its commands and shuts down its sending side (nc -N) still gets every
+ * reply: its queued commands are not mistaken for a hangup.
+ */
+static void testHalfCloseKeepsReplies(GraphRegistry& registry, SessionStages& stages)
+{
+    Reactor reactor;
+    auto [client, server] = connectLoopback();
+    spawn(serve(reactor, server, registry, stages));
+    std::thread loop([&reactor]() { reactor.run(); });
+
+    sendText(client, "generate random n=200 m=1000 seed=2\nmst prim\nanalyze\nexit\n");
+    shutdown(client, SHUT_WR);
+    std::string replies = readUntil(client, "\x01", 1); // Everything until the server closes
+    loop.join();
+    close(client);
+    CHECK(replies.find("MST created") != std::string::npos);
+    CHECK(replies.find("Average Edge Count") != std::string::npos);
+}
+
+int main()
+{
+    GraphRegistry registry;
+    ThreadPool pool(2);
+    SessionStages stages{Executor::of(pool), Executor::of(pool), Executor::of(pool), pool};
+    testCloseCancelsAnalyze(registry, stages);
+    testHalfCloseKeepsReplies(registry, stages);
+    return checkResult("hangup_test");
+}
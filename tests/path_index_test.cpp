@@ -0,0 +1,90 @@
+#include "check.hpp"
+#include "path_index.hpp"
+
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using Edge = std::tuple<int, int, int, int>;
+
+// Random spanning forest: vertex v > 0 hangs off a random earlier vertex of its tree, or starts a
+// new tree. chain makes most parents the previous vertex, for deep trees.
+static std::vector<Edge> randomForest(int n, int trees, bool chain, std::mt19937& random)
+{
+    std::vector<Edge> edges;
+    std::uniform_int_distribution<int> weight(1, 1000);
+    for (int v = 0; v < n; ++v) {
+        if (v % (n / trees) == 0) continue; // Root of a new tree
+        int first = v - v % (n / trees);
+        int parent = chain && random() % 8 != 0 ? v - 1 : first + static_cast<int>(random() % (v - first));
+        edges.emplace_back(parent, v, weight(random), static_cast<int>(edges.size()));
+    }
+    return edges;
+}
+
+// Walks the tree from u to find v: distance, hops and heaviest edge of the path, or -1 if unreachable
+static PairAnswer bruteForce(const std::vector<std::vector<std::pair<int, int>>>& adj, int u, int v)
+{
+    int n = static_cast<int>(adj.size());
+    std::vector<int> parent(n, -2), parentWeight(n, 0);
+    std::vector<int> stack{u};
+    parent[u] = -1;
+    while (!stack.empty()) {
+        int x = stack.back();
+        stack.pop_back();
+        for (auto [y, w] : adj[x]) {
+            if (parent[y] != -2) continue;
+            parent[y] = x;
+            parentWeight[y] = w;
+            stack.push_back(y);
+        }
+    }
+    if (parent[v] == -2) return {-1, -1, 0};
+    PairAnswer answer{0, 0, 0};
+    for (int x = v; x != u; x = parent[x]) {
+        answer.distance += parentWeight[x];
+        answer.hops += 1;
+        answer.heaviestEdge = std::max(answer.heaviestEdge, parentWeight[x]);
+    }
+    return answer;
+}
+
+static void checkForest(int n, int trees, bool chain, int pairCount, ThreadPool& pool, std::mt19937& random)
+{
+    std::vector<Edge> edges = randomForest(n, trees, chain, random);
+    std::vector<std::vector<std::pair<int, int>>> adj(n);
+    for (const auto& [u, v, w, id] : edges) {
+        adj[u].emplace_back(v, w);
+        adj[v].emplace_back(u, w);
+    }
+
+    std::vector<std::pair<int, int>> pairs;
+    std::uniform_int_distribution<int> vertex(0, n - 1);
+    for (int i = 0; i < pairCount; ++i) pairs.emplace_back(vertex(random), vertex(random));
+    pairs.emplace_back(0, 0);
+
+    PathIndex index(edges, n);
+    std::vector<PairAnswer> answers = index.queryAll(pairs, pool);
+    CHECK_EQ(answers.size(), pairs.size());
+    for (size_t i = 0; i < pairs.size() && i < answers.size(); ++i) {
+        auto [u, v] = pairs[i];
+        PairAnswer expected = bruteForce(adj, u, v);
+        CHECK_EQ(answers[i].distance, expected.distance);
+        CHECK_EQ(answers[i].hops, expected.hops);
+        if (expected.distance >= 0) CHECK_EQ(answers[i].heaviestEdge, expected.heaviestEdge);
+
+        PairAnswer single = index.query(u, v);
+        CHECK_EQ(single.distance, answers[i].distance);
+    }
+}
+
+int main()
+{
+    std::mt19937 random(31);
+    ThreadPool pool(4);
+    checkForest(60, 1, false, 400, pool, random);   // One bushy tree
+    checkForest(60, 3, false, 400, pool, random);   // Several trees: unreachable pairs too
+    checkForest(3000, 2, true, 300, pool, random);  // Deep trees exercise every lifting level
+    return checkResult("path_index_test");
+}
@@ -0,0 +1,167 @@
+#include "trace.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define FLUSH_EVENTS 256 // Events written between two automatic flushes
+
+namespace trace {
+
+using Clock = std::chrono::steady_clock;
+
+static thread_local uint64_t request = 0;
+
+/**
+ * Class: Writer
+ * Appends events to the trace file as one JSON array. The closing bracket is written at exit;
+ * a trace cut short (e.g. a killed server) is still accepted by the viewers.
+ */
+class Writer {
+public:
+    static Writer& instance()
+    {
+        static Writer writer;
+        return writer;
+    }
+
+    // Microseconds since tracing started
+    long long micros(Clock::time_point at) const
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(at - origin).count();
+    }
+
+    // Writes one event; fields is the JSON of the event without its braces
+    void write(const std::string& fields)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!file) return;
+        fprintf(file, "%s{%s}", first ? "\n" : ",\n", fields.c_str());
+        first = false;
+        if (++pending >= FLUSH_EVENTS) {
+            fflush(file);
+            pending = 0;
+        }
+    }
+
+    void flush()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (file) fflush(file);
+        pending = 0;
+    }
+
+private:
+    std::mutex mutex;
+    FILE* file;
+    bool first = true;
+    int pending = 0;
+    Clock::time_point origin = Clock::now();
+
+    Writer()
+    {
+        const char* path = getenv("MST_TRACE_FILE");
+        file = fopen(path ? path : "mst_trace.json", "w");
+        if (file) fputs("[", file);
+    }
+
+    ~Writer()
+    {
+        if (file) {
+            fputs("\n]\n", file);
+            fclose(file);
+        }
+    }
+};
+
+static long threadId()
+{
+    static thread_local long tid = syscall(SYS_gettid);
+    return tid;
+}
+
+// JSON string literal of text
+static std::string quote(const std::string& text)
+{
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+// Fields shared by every event: name, phase, timestamp, process and thread
+static std::string common(const std::string& name, char phase, Clock::time_point at)
+{
+    return "\"name\":" + quote(name) + ",\"ph\":\"" + phase + "\",\"ts\":" +
+           std::to_string(Writer::instance().micros(at)) + ",\"pid\":" + std::to_string(getpid()) +
+           ",\"tid\":" + std::to_string(threadId());
+}
+
+uint64_t currentRequest()
+{
+    return request;
+}
+
+uint64_t nextRequest()
+{
+    static std::atomic<uint64_t> counter{0};
+    return ++counter;
+}
+
+void nameThread(const std::string& name)
+{
+    Writer::instance().write("\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + std::to_string(getpid()) +
+                             ",\"tid\":" + std::to_string(threadId()) + ",\"args\":{\"name\":" + quote(name) + "}");
+}
+
+void flush()
+{
+    Writer::instance().flush();
+}
+
+RequestScope::RequestScope(uint64_t id) : previous(request)
+{
+    request = id;
+}
+
+RequestScope::~RequestScope()
+{
+    request = previous;
+}
+
+Span::Span(const char* name) : name(name), request(trace::request), start(Clock::now()) {}
+
+Span::~Span()
+{
+    Clock::time_point end = Clock::now();
+    long long duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    Writer::instance().write(common(name, 'X', start) + ",\"dur\":" + std::to_string(duration) +
+                             ",\"args\":{\"request\":" + std::to_string(request) + "}");
+}
+
+AsyncSpan::AsyncSpan(std::string name, uint64_t request) : name(std::move(name)), request(request)
+{
+    Writer::instance().write(common(this->name, 'b', Clock::now()) + ",\"cat\":\"request\",\"id\":" +
+                             std::to_string(request) + ",\"args\":{\"request\":" + std::to_string(request) + "}");
+}
+
+AsyncSpan::~AsyncSpan()
+{
+    Writer::instance().write(common(name, 'e', Clock::now()) + ",\"cat\":\"request\",\"id\":" +
+                             std::to_string(request));
+}
+
+} // namespace trace
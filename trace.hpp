@@ -0,0 +1,92 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * Phase tracing in the Chrome trace-event format (open the file in chrome://tracing or
+ * ui.perfetto.dev). Built in only with -DMST_TRACE (make TRACE=1); otherwise the TRACE_* macros
+ * expand to nothing and cost nothing.
+ *
+ * TRACE_SPAN("name") records the enclosing scope as a complete event on the calling thread,
+ * tagged with the thread's current request id. TRACE_REQUEST(id) sets that id for the enclosing
+ * scope. Scopes that span a co_await must use TRACE_ASYNC instead: interleaved coroutines on the
+ * reactor thread would otherwise produce overlapping spans on the same thread.
+ *
+ * Events go to the file named by MST_TRACE_FILE (default mst_trace.json).
+ */
+namespace trace {
+
+// Id of the request the calling thread works for, 0 for none
+uint64_t currentRequest();
+
+// New request id, unique in the process
+uint64_t nextRequest();
+
+// Names the calling thread in the trace
+void nameThread(const std::string& name);
+
+// Writes buffered events to the file
+void flush();
+
+// Sets the current request of the calling thread for its lifetime
+class RequestScope {
+public:
+    explicit RequestScope(uint64_t request);
+    ~RequestScope();
+    RequestScope(const RequestScope&) = delete;
+    RequestScope& operator=(const RequestScope&) = delete;
+
+private:
+    uint64_t previous;
+};
+
+// A complete ("X") event covering the object's lifetime
+class Span {
+public:
+    explicit Span(const char* name);
+    ~Span();
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    const char* name;
+    uint64_t request;
+    std::chrono::steady_clock::time_point start;
+};
+
+// An async ("b"/"e") event pair keyed by request id; may be suspended across co_await
+class AsyncSpan {
+public:
+    AsyncSpan(std::string name, uint64_t request);
+    ~AsyncSpan();
+    AsyncSpan(const AsyncSpan&) = delete;
+    AsyncSpan& operator=(const AsyncSpan&) = delete;
+
+private:
+    std::string name;
+    uint64_t request;
+};
+
+} // namespace trace
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#ifdef MST_TRACE
+#define TRACE_SPAN(name) ::trace::Span TRACE_CONCAT(traceSpan_, __LINE__)(name)
+#define TRACE_REQUEST(id) ::trace::RequestScope TRACE_CONCAT(traceRequest_, __LINE__)(id)
+#define TRACE_ASYNC(name, id) ::trace::AsyncSpan TRACE_CONCAT(traceAsync_, __LINE__)(name, id)
+#define TRACE_THREAD(name) ::trace::nameThread(name)
+#define TRACE_FLUSH() ::trace::flush()
+#else
+#define TRACE_SPAN(name) ((void)0)
+#define TRACE_REQUEST(id) ((void)0)
+#define TRACE_ASYNC(name, id) ((void)0)
+#define TRACE_THREAD(name) ((void)0)
+#define TRACE_FLUSH() ((void)0)
+#endif
+
+#endif // TRACE_HPP